@@ -2,6 +2,8 @@
 
 #include <boost/optional/optional.hpp>
 
+#include <utility>
+
 template <typename Q>
 struct OptionalAware
 {
@@ -9,7 +11,7 @@ struct OptionalAware
     *  just call the specific function.
     */
    template <typename T>
-   static auto call(T&& v) { return Q::call(v); }
+   static auto call(T&& v) { return Q::call(std::forward<T>(v)); }
    
    /** This is never called because pipe operator
     *  has an overload for optional and handles it 
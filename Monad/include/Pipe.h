@@ -3,9 +3,39 @@
 #include <boost/optional/optional.hpp>
 
 #include <tuple>
+#include <utility>
+#include <type_traits>
+
+/** Starts a lazy pipe expression, see Pipeline */
+struct Lazy {};
+
+template <typename... F>
+struct Pipeline;
 
 namespace detail
 {
+   template <typename T>
+   struct isLazy : std::false_type {};
+
+   template <>
+   struct isLazy<Lazy> : std::true_type {};
+
+   template <typename... F>
+   struct isLazy<Pipeline<F...>> : std::true_type {};
+
+   /** Excludes lazy expressions from the eager operators below before their
+       return types get evaluated, that would call the functions with them.
+    */
+   template <typename T>
+   using Eager = typename std::enable_if<!isLazy<typename std::decay<T>::type>::value>::type;
+
+   /** Selects the void function versions below by the forwarded argument first, before their
+       return types check the call with a const reference. Otherwise a generic function not
+       accepting a const reference would fail to compile instead of being skipped.
+    */
+   template <typename F, typename T>
+   using VoidFor = typename std::enable_if<std::is_void<decltype(std::declval<F&>()(std::declval<T>()))>::value>::type;
+
    /** Non-tuples and tuples with more than 1 entry
        are forwarded as they are.
     */
@@ -24,8 +54,8 @@ namespace detail
    static auto normalize(boost::optional<std::tuple<V>>&& v) -> boost::optional<V> 
    {
       if (v)
-      {  return boost::make_optional(normalize(*v)); }
-      return boost::optional<decltype(normalize(*v))>( /*empty*/ );
+      {  return boost::optional<V>(normalize(std::move(*v))); }
+      return boost::optional<V>( /*empty*/ );
    }
 }
 
@@ -35,49 +65,111 @@ namespace detail
    
     Non-void function version.
  */
-template <typename T, typename F>
-auto operator | (T&& t, F&& f) -> typename std::enable_if<!std::is_void<decltype(detail::normalize(f(t)))>::value, decltype(detail::normalize(f(t)))>::type 
-{  return std::forward<decltype(detail::normalize(f(t)))>(detail::normalize(f(std::forward<T>(t)))); }
+template <typename T, typename F, typename = detail::Eager<T>>
+auto operator | (T&& t, F&& f) -> typename std::enable_if<!std::is_void<decltype(detail::normalize(f(std::forward<T>(t))))>::value, decltype(detail::normalize(f(std::forward<T>(t))))>::type 
+{  return detail::normalize(f(std::forward<T>(t))); }
 
 /** When the argument is optional, the function is
-    called only when the argument is set.
+    called only when the argument is set. The value
+    is moved out of the optional into the function.
 
     Non-void function version for optional arguments.
  */
 template <typename T, typename F>
-auto operator | (boost::optional<T>&& t, F&& f) -> typename std::enable_if<!std::is_void<decltype(detail::normalize(f(*t)))>::value, boost::optional<decltype(operator|(*t, f))>>::type
+auto operator | (boost::optional<T>&& t, F&& f) -> typename std::enable_if<!std::is_void<decltype(detail::normalize(f(std::move(*t))))>::value, boost::optional<decltype(operator|(std::move(*t), f))>>::type
 {  
    if (t)
-   {  return boost::make_optional(operator|(*t, f)); }
-   return boost::optional<decltype(operator|(*t, f))>( /*empty*/ );
+   {  return boost::optional<decltype(operator|(std::move(*t), f))>(operator|(std::move(*t), f)); }
+   return boost::optional<decltype(operator|(std::move(*t), f))>( /*empty*/ );
 }
 
-/** Function is called with a copy of the argument.
+/** Function is called with a const reference to the argument,
+    so it is copied only when the function takes it by value.
     The argument is forwarded to the next.
     
     \remark We don't have to normalize here, because the argument is forwarded and not changed, hence it is already normalized
    
     Void function version.
  */
-template <typename T, typename F>
-auto operator | (T&& t, F&& f) -> typename std::enable_if<std::is_void<decltype(f(t))>::value, T>::type
+template <typename T, typename F, typename = detail::Eager<T>, typename = detail::VoidFor<F, T>>
+auto operator | (T&& t, F&& f) -> typename std::enable_if<std::is_void<decltype(f(std::declval<typename std::decay<T>::type const&>()))>::value, T>::type
 {  
    auto const& _t(t);
    f(_t); ///< Force const reference as parameter
    return std::forward<T>(t); //< forward parameter
 } 
 
-/** Function is called when the optional is present with a copy of the value.
+/** Function is called when the optional is present with a const reference to the value.
     The optional argument is forwarded to the next.
     
     \remark We don't have to normalize here, because the argument is forwarded and not changed, hence it is already normalized
    
     Void function version for optional arguments.
  */
-template <typename T, typename F>
-auto operator | (boost::optional<T>&& t, F&& f) -> typename std::enable_if<std::is_void<decltype(f(*t))>::value, boost::optional<T>>::type
+template <typename T, typename F, typename = detail::VoidFor<F, T>>
+auto operator | (boost::optional<T>&& t, F&& f) -> typename std::enable_if<std::is_void<decltype(f(std::declval<T const&>()))>::value, boost::optional<T>>::type
 {  
    if (t) 
    {  operator|(*t, f); } 
    return std::forward<boost::optional<T>>(t); //< forward parameter
 }
+
+namespace detail
+{
+   template <typename...>
+   struct voider { typedef void type; };
+
+   /** Result of piping a T through all Steps, no type when one of the steps does not accept
+       the result of the previous one. Keeps Pipeline::operator() SFINAE friendly, so the
+       eager operators can check a pipeline as a step without instantiating its body.
+    */
+   template <typename T, typename Steps, typename = void>
+   struct folded {};
+
+   template <typename T>
+   struct folded<T, std::tuple<>, void>
+   {  typedef typename std::decay<T>::type type; };
+
+   template <typename T, typename G, typename... H>
+   struct folded<T, std::tuple<G, H...>, typename voider<decltype(std::declval<T>() | std::declval<G const&>())>::type>
+      : folded<decltype(std::declval<T>() | std::declval<G const&>()), std::tuple<H...>> {};
+}
+
+/** Composition of functions built by 'Lazy() | f | g | h' without calling any of them.
+    Applied to a value by 'v | pipeline' or 'pipeline(v)', the steps are evaluated
+    in one go, with the same rules as the eager operators above. Intermediate
+    values are temporaries of a single expression and are moved from step to step.
+    A pipeline can be applied any number of times and is a step itself.
+ */
+template <typename... F>
+struct Pipeline
+{
+   explicit Pipeline(std::tuple<F...> steps) : m_steps(std::move(steps)) {}
+
+   template <typename T>
+   auto operator()(T&& t) const -> typename detail::folded<T&&, std::tuple<F...>>::type
+   {  return apply(std::forward<T>(t), std::index_sequence_for<F...>()); }
+
+   std::tuple<F...> m_steps;
+
+private:
+   template <typename T, std::size_t... I>
+   auto apply(T&& t, std::index_sequence<I...>) const
+   {  return fold(std::forward<T>(t), std::get<I>(m_steps)...); }
+
+   template <typename T>
+   static typename std::decay<T>::type fold(T&& t)
+   {  return std::forward<T>(t); }
+
+   template <typename T, typename G, typename... H>
+   static auto fold(T&& t, G const& g, H const&... h)
+   {  return fold(std::forward<T>(t) | g, h...); }
+};
+
+template <typename F>
+auto operator | (Lazy, F&& f)
+{  return Pipeline<typename std::decay<F>::type>(std::make_tuple(std::forward<F>(f))); }
+
+template <typename... F, typename G>
+auto operator | (Pipeline<F...> p, G&& g)
+{  return Pipeline<F..., typename std::decay<G>::type>(std::tuple_cat(std::move(p.m_steps), std::make_tuple(std::forward<G>(g)))); }
@@ -3,7 +3,9 @@
 #include <boost/optional/optional.hpp>
 
 #include <istream>
+#include <string>
 #include <tuple>
+#include <utility>
 
 struct Reader
 {   
@@ -12,7 +14,7 @@ struct Reader
    {  
       T value; 
       is >> value; 
-      return createResult(v, value); 
+      return createResult(std::forward<V>(v), std::move(value)); 
    }
    
    template <typename V>
@@ -20,17 +22,18 @@ struct Reader
    {  
       std::string line; 
       std::getline(is, line); 
-      return createResult(v, line); 
+      return createResult(std::forward<V>(v), std::move(line)); 
    }
    
 private:
+   /** Values given as rvalues are moved into the result */
    template <typename T, typename V>
    static auto createResult(V&& v, T&& value)
-   {  return std::make_tuple(v, value); }
+   {  return std::make_tuple(std::forward<V>(v), std::forward<T>(value)); }
    
    template <typename T, typename... V>
    static auto createResult(std::tuple<V...> v, T&& value)
-   {  return std::tuple_cat(v, std::make_tuple(value)); }
+   {  return std::tuple_cat(std::move(v), std::make_tuple(std::forward<T>(value))); }
   
 // \todo We do need this overload for optionals
 // 
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "Pipe.h"
+
+#include <boost/utility/string_view.hpp>
+
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <iterator>
+#include <utility>
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+#include <type_traits>
+
+/** Lines of a stream as views into a buffer of its own, read in large blocks.
+    No string is allocated per line, the buffer grows only for lines longer
+    than it is. A view stays valid until the iterator is incremented.
+    Lines are split like std::getline does it.
+ */
+class Lines
+{
+public:
+   explicit Lines(std::istream& is, size_t bufferSize = 1 << 16) : m_is(is), m_buffer(std::max<size_t>(bufferSize, 1)), m_begin(0), m_end(0), m_eof(false) {}
+
+   Lines(Lines const&) = delete;
+   Lines& operator=(Lines const&) = delete;
+
+   Lines(Lines&&) = default;
+
+   struct iterator
+   {
+      typedef std::input_iterator_tag iterator_category;
+      typedef boost::string_view value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef value_type const* pointer;
+      typedef value_type const& reference;
+
+      iterator() : m_lines(nullptr), m_line() {}
+      explicit iterator(Lines& lines) : m_lines(&lines), m_line() { ++*this; }
+
+      reference operator*() const
+      {  return m_line; }
+
+      pointer operator->() const
+      {  return &m_line; }
+
+      iterator& operator++()
+      {
+         if (!m_lines->next(m_line))
+         {  m_lines = nullptr; }
+         return *this;
+      }
+
+      friend bool operator==(iterator const& a, iterator const& b)
+      {  return a.m_lines == b.m_lines; }
+
+      friend bool operator!=(iterator const& a, iterator const& b)
+      {  return !(a == b); }
+
+   private:
+      Lines* m_lines;
+      boost::string_view m_line;
+   };
+
+   iterator begin()
+   {  return iterator(*this); }
+
+   iterator end()
+   {  return iterator(); }
+
+private:
+   bool next(boost::string_view& line)
+   {
+      for (;;)
+      {
+         auto const data(m_buffer.data());
+         auto const found(static_cast<char const*>(std::memchr(data + m_begin, '\n', m_end - m_begin)));
+         if (found != nullptr)
+         {
+            line = boost::string_view(data + m_begin, found - (data + m_begin));
+            m_begin = found - data + 1;
+            return true;
+         }
+         if (m_eof)
+         {
+            if (m_begin == m_end)
+            {  return false; }
+            line = boost::string_view(data + m_begin, m_end - m_begin); ///< Last line without line end
+            m_begin = m_end;
+            return true;
+         }
+         fill();
+      }
+   }
+
+   /** Moves the incomplete line to the front and appends the next block */
+   void fill()
+   {
+      auto const rest(m_end - m_begin);
+      std::memmove(m_buffer.data(), m_buffer.data() + m_begin, rest);
+      m_begin = 0;
+      m_end = rest;
+      if (m_end == m_buffer.size())
+      {  m_buffer.resize(m_buffer.size() * 2); }
+
+      m_is.read(m_buffer.data() + m_end, m_buffer.size() - m_end);
+      m_end += m_is.gcount();
+      m_eof = !m_is;
+   }
+
+   std::istream& m_is;
+   std::vector<char> m_buffer;
+   size_t m_begin; ///< Start of the next line
+   size_t m_end;   ///< End of the valid bytes
+   bool m_eof;
+};
+
+/** Words of a line as views into it, split at tabs and blanks like
+    boost::split with is_any_of("\t ") does it, empty words included.
+ */
+class Words
+{
+public:
+   explicit Words(boost::string_view line) : m_line(line) {}
+
+   struct iterator
+   {
+      typedef std::forward_iterator_tag iterator_category;
+      typedef boost::string_view value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef value_type const* pointer;
+      typedef value_type reference;
+
+      iterator() : m_line(), m_begin(boost::string_view::npos), m_end(boost::string_view::npos) {}
+      explicit iterator(boost::string_view line) : m_line(line), m_begin(0), m_end(find(0)) {}
+
+      reference operator*() const
+      {  return m_line.substr(m_begin, m_end - m_begin); }
+
+      iterator& operator++()
+      {
+         if (m_end == m_line.size())
+         {  m_begin = m_end = boost::string_view::npos; }
+         else
+         {
+            m_begin = m_end + 1;
+            m_end = find(m_begin);
+         }
+         return *this;
+      }
+
+      iterator operator++(int)
+      {
+         auto r(*this);
+         ++*this;
+         return r;
+      }
+
+      friend bool operator==(iterator const& a, iterator const& b)
+      {  return a.m_begin == b.m_begin; }
+
+      friend bool operator!=(iterator const& a, iterator const& b)
+      {  return !(a == b); }
+
+   private:
+      size_t find(size_t from) const
+      {
+         auto const r(m_line.find_first_of("\t ", from));
+         return r == boost::string_view::npos ? m_line.size() : r;
+      }
+
+      boost::string_view m_line;
+      size_t m_begin;
+      size_t m_end;
+   };
+
+   iterator begin() const
+   {  return iterator(m_line); }
+
+   iterator end() const
+   {  return iterator(); }
+
+   size_t size() const
+   {  return std::distance(begin(), end()); }
+
+   friend std::ostream& operator<<(std::ostream& os, Words const& words)
+   {
+      os << '[';
+      auto separator("");
+      for (auto const& w : words)
+      {  os << separator << w; separator = ", "; }
+      return os << ']';
+   }
+
+private:
+   boost::string_view m_line;
+};
+
+/** Step applying a function or pipeline to every element of a range, like 'Lines(is) | each(pipeline)'.
+    Returns the number of elements.
+ */
+template <typename F>
+struct Each
+{
+   template <typename R>
+   size_t operator()(R&& range) const
+   {
+      size_t count(0);
+      for (auto&& e : range)
+      {
+         std::forward<decltype(e)>(e) | m_function;
+         ++count;
+      }
+      return count;
+   }
+
+   F m_function;
+};
+
+template <typename F>
+auto each(F&& f)
+{  return Each<typename std::decay<F>::type>{std::forward<F>(f)}; }
@@ -3,14 +3,17 @@
 #include "../include/Reader.h"
 #include "../include/Writer.h"
 #include "../include/OptionalAware.h"
+#include "../include/Stream.h"
 
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/optional/optional.hpp>
 
 #include <iostream>
+#include <string>
 #include <tuple>
 #include <vector>
+#include <utility>
 
 struct Multiplier : public OptionalAware<Multiplier>
 {   
@@ -47,8 +50,12 @@ struct WordSplitter : public OptionalAware<WordSplitter>
    {
       std::vector<std::string> words;
       boost::split(words, v, boost::is_any_of("\t "));
-      return std::make_tuple(words);
+      return std::make_tuple(std::move(words));
    }
+
+   /** Views into the line instead of copies */
+   static auto call(boost::string_view v)
+   {  return std::make_tuple(Words(v)); }
 };
 
 int main(int argc, char** argv)
@@ -58,18 +65,27 @@ int main(int argc, char** argv)
       
    //auto const readString([&](auto v) { return Reader::read<std::string>(is, v); });
    //auto const readInt   ([&](auto v) { return Reader::read<int>(is, v); });
-   auto const readLine  ([&](auto v) { return Reader::readLine(is, v); });
-   auto const readReal  ([&](auto v) { return Reader::read<double>(is, v); });
-   auto const write     ([&](auto v) { Writer::write(os, v); });
-   auto const trace     ([&](auto v) { os << "trace: "; Writer::write(os, v); os << '\n'; });
+   auto const readLine  ([&](auto&& v) { return Reader::readLine(is, std::forward<decltype(v)>(v)); });
+   auto const readReal  ([&](auto&& v) { return Reader::read<double>(is, std::forward<decltype(v)>(v)); });
+   auto const write     ([&](auto const& v) { Writer::write(os, v); });
+   auto const trace     ([&](auto const& v) { os << "trace: "; Writer::write(os, v); os << '\n'; });
    
-   auto const multiply  ([](auto v) { return OptionalAware<Multiplier  >::call(v); });
-   auto const devide    ([](auto v) { return OptionalAware<Devider     >::call(v); });
-   auto const count     ([](auto v) { return OptionalAware<Counter     >::call(v); });
-   auto const splitWords([](auto v) { return OptionalAware<WordSplitter>::call(v); });
+   auto const multiply  ([](auto&& v) { return OptionalAware<Multiplier  >::call(std::forward<decltype(v)>(v)); });
+   auto const devide    ([](auto&& v) { return OptionalAware<Devider     >::call(std::forward<decltype(v)>(v)); });
+   auto const count     ([](auto&& v) { return OptionalAware<Counter     >::call(std::forward<decltype(v)>(v)); });
+   auto const splitWords([](auto&& v) { return OptionalAware<WordSplitter>::call(std::forward<decltype(v)>(v)); });
    
-   //boost::optional<std::tuple<>>()
-   std::make_tuple()
+   /** Applies the pipeline to every line of the input */
+   if (argc > 1 && std::string(argv[1]) == "--lines")
+   {
+      std::ios::sync_with_stdio(false);
+      auto const writeLine([&](auto const& v) { Writer::write(os, v); os << '\n'; });
+      Lines(is) | each(Lazy() | splitWords | count | writeLine);
+      return 0;
+   }
+
+   /** Nothing is read or computed before the pipeline gets applied */
+   auto const pipeline(Lazy()
       | readLine     |  trace
       | splitWords   |  trace
       | count        |  trace
@@ -77,7 +93,10 @@ int main(int argc, char** argv)
       | devide       |  trace
       | readReal     |  trace
       | multiply     |  trace
-      | write;
+      | write);
+
+   //boost::optional<std::tuple<>>()
+   std::make_tuple() | pipeline;
    
    os << '\n';
 }
@@ -0,0 +1,68 @@
+
+#include "../include/Pipe.h"
+
+#include <gtest/gtest.h>
+
+#include <boost/optional/optional.hpp>
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+   auto const twice  ([](int v) { return 2 * v; });
+   auto const pair   ([](int v) { return std::make_tuple(v, v + 1); });
+   auto const add    ([](std::tuple<int, int> v) { return std::get<0>(v) + std::get<1>(v); });
+   auto const wrap   ([](int v) { return std::make_tuple(v); }); ///< Normalized to int
+   auto const halve  ([](int v) { return v % 2 == 0 ? boost::make_optional(v / 2) : boost::optional<int>(); });
+}
+
+TEST(LazyPipe, NothingCalledBeforeApplied)
+{
+   std::vector<std::string> calls;
+   auto const pipeline(Lazy()
+      | [&](int v) { calls.push_back("first"); return v + 1; }
+      | [&](int const&) { calls.push_back("inspect"); }
+      | [&](int v) { calls.push_back("last"); return v * 3; });
+   EXPECT_TRUE(calls.empty());
+
+   EXPECT_EQ(9, 2 | pipeline);
+   EXPECT_EQ((std::vector<std::string>{"first", "inspect", "last"}), calls);
+}
+
+TEST(LazyPipe, SameAsEager)
+{
+   auto const pipeline(Lazy() | twice | pair | add | wrap | twice);
+   EXPECT_EQ(3 | twice | pair | add | wrap | twice, 3 | pipeline);
+   EXPECT_EQ(26, pipeline(3));
+}
+
+TEST(LazyPipe, AppliedRepeatedly)
+{
+   auto const pipeline(Lazy() | twice | pair | add);
+   EXPECT_EQ(5, 1 | pipeline);
+   EXPECT_EQ(9, 2 | pipeline);
+   EXPECT_EQ(9, 2 | pipeline);
+}
+
+TEST(LazyPipe, Optional)
+{
+   std::vector<int> seen;
+   auto const pipeline(Lazy() | halve | [&](int const& v) { seen.push_back(v); } | twice);
+
+   auto const set(4 | pipeline);
+   ASSERT_TRUE(static_cast<bool>(set));
+   EXPECT_EQ(4, *set);
+
+   auto const unset(3 | pipeline);
+   EXPECT_FALSE(static_cast<bool>(unset));
+   EXPECT_EQ((std::vector<int>{2}), seen);
+}
+
+TEST(LazyPipe, Nested)
+{
+   auto const inner(Lazy() | pair | add);
+   auto const outer(Lazy() | twice | inner | inner);
+   EXPECT_EQ(3 | twice | pair | add | pair | add, 3 | outer);
+}
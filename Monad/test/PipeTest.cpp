@@ -0,0 +1,121 @@
+
+#include "../include/Pipe.h"
+#include "../include/Reader.h"
+
+#include <gtest/gtest.h>
+
+#include <boost/optional/optional.hpp>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace
+{
+   /** Large payload counting how often it gets copied */
+   struct Counted
+   {
+      Counted() : m_payload(1000, "word") {}
+      Counted(Counted const& other) : m_payload(other.m_payload) { ++s_copies; }
+      Counted(Counted&& other) noexcept : m_payload(std::move(other.m_payload)) {}
+      Counted& operator=(Counted const&) = delete;
+      Counted& operator=(Counted&&) = delete;
+
+      std::vector<std::string> m_payload;
+      static int s_copies;
+   };
+
+   int Counted::s_copies = 0;
+
+   auto const pass   ([](Counted v) { return v; });                          ///< Takes ownership
+   auto const wrap   ([](Counted&& v) { return std::make_tuple(std::move(v)); }); ///< Normalized back to Counted
+   auto const inspect([](Counted const& v) { EXPECT_EQ(1000u, v.m_payload.size()); });
+
+   template <typename T, typename F, typename = void>
+   struct pipes : std::false_type {};
+
+   template <typename T, typename F>
+   struct pipes<T, F, decltype(void(std::declval<T>() | std::declval<F>()))> : std::true_type {};
+}
+
+TEST(Pipe, NoCopiesThroughTenStages)
+{
+   Counted::s_copies = 0;
+   auto const r(Counted()
+      | pass | wrap | inspect | pass | wrap
+      | inspect | pass | wrap | inspect | pass);
+   EXPECT_EQ(1000u, r.m_payload.size());
+   EXPECT_EQ(0, Counted::s_copies);
+}
+
+TEST(Pipe, NoCopiesThroughLazyPipeline)
+{
+   auto const pipeline(Lazy()
+      | pass | wrap | inspect | pass | wrap
+      | inspect | pass | wrap | inspect | pass);
+
+   Counted::s_copies = 0;
+   auto const r(Counted() | pipeline);
+   EXPECT_EQ(1000u, r.m_payload.size());
+   EXPECT_EQ(0, Counted::s_copies);
+}
+
+TEST(Pipe, NoCopiesThroughOptional)
+{
+   Counted::s_copies = 0;
+   auto const r(boost::optional<Counted>(Counted()) | pass | inspect | wrap | inspect | pass);
+   ASSERT_TRUE(static_cast<bool>(r));
+   EXPECT_EQ(1000u, r->m_payload.size());
+   EXPECT_EQ(0, Counted::s_copies);
+
+   auto const empty(boost::optional<Counted>() | pass | inspect);
+   EXPECT_FALSE(static_cast<bool>(empty));
+}
+
+TEST(Pipe, NoCopiesThroughReader)
+{
+   std::istringstream is("2 3");
+   auto const readInt([&](auto&& v) { return Reader::read<int>(is, std::forward<decltype(v)>(v)); });
+
+   Counted::s_copies = 0;
+   auto const r(Counted() | readInt | readInt);
+   EXPECT_EQ(1000u, std::get<0>(r).m_payload.size());
+   EXPECT_EQ(2, std::get<1>(r));
+   EXPECT_EQ(3, std::get<2>(r));
+   EXPECT_EQ(0, Counted::s_copies);
+}
+
+TEST(Pipe, MoveOnly)
+{
+   std::istringstream is("6");
+   auto const readInt ([&](auto&& v) { return Reader::read<int>(is, std::forward<decltype(v)>(v)); });
+   auto const multiply([](std::tuple<std::unique_ptr<int>, int> v) { return *std::get<0>(v) * std::get<1>(v); });
+   auto const check   ([](std::unique_ptr<int> const& v) { EXPECT_EQ(7, *v); });
+   auto const own     ([](std::unique_ptr<int> v) { return v; });
+
+   EXPECT_EQ(42, std::make_unique<int>(7) | check | own | readInt | multiply);
+
+   auto const pipeline(Lazy() | own | check | own);
+   auto const r(boost::optional<std::unique_ptr<int>>(std::make_unique<int>(7)) | pipeline);
+   ASSERT_TRUE(static_cast<bool>(r));
+   EXPECT_EQ(7, **r);
+}
+
+TEST(Pipe, VoidStepsTakeConstReferences)
+{
+   auto const byConstReference([](Counted const&) {});
+   auto const byRvalue        ([](Counted&&) {});
+   auto const byLvalue        ([](Counted&) {});
+   auto const pipeline(Lazy() | pass | inspect);
+
+   static_assert(pipes<Counted, decltype(byConstReference)>::value, "Void step gets a const reference");
+   static_assert(!pipes<Counted, decltype(byRvalue)>::value, "Rejected instead of failing in the body");
+   static_assert(!pipes<Counted, decltype(byLvalue)>::value, "Rejected instead of failing in the body");
+   static_assert(!pipes<boost::optional<Counted>, decltype(byRvalue)>::value, "Rejected instead of failing in the body");
+   static_assert(pipes<Counted, decltype(pipeline)>::value, "Pipeline is a step");
+   static_assert(!pipes<std::string, decltype(pipeline)>::value, "Pipeline rejects what its steps reject");
+}
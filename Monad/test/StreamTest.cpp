@@ -0,0 +1,73 @@
+
+#include "../include/Stream.h"
+
+#include <gtest/gtest.h>
+
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+   std::vector<std::string> readAll(std::string const& input, size_t bufferSize)
+   {
+      std::istringstream is(input);
+      std::vector<std::string> r;
+      for (auto const& line : Lines(is, bufferSize))
+      {  r.emplace_back(line.data(), line.size()); }
+      return r;
+   }
+
+   std::vector<std::string> splitAll(std::string const& line)
+   {
+      std::vector<std::string> r;
+      for (auto const& word : Words(line))
+      {  r.emplace_back(word.data(), word.size()); }
+      return r;
+   }
+}
+
+TEST(Stream, LinesLikeGetline)
+{
+   std::string const input("first\n\nthird line is longer than the buffer\r\nlast");
+   std::vector<std::string> expected;
+   std::istringstream is(input);
+   for (std::string line; std::getline(is, line); )
+   {  expected.push_back(line); }
+
+   EXPECT_EQ(expected, readAll(input, 4));       ///< Grows and compacts the buffer
+   EXPECT_EQ(expected, readAll(input, 1 << 16));
+   EXPECT_EQ(expected, readAll(input + '\n', 4)); ///< No empty line at the end
+   EXPECT_TRUE(readAll("", 4).empty());
+}
+
+TEST(Stream, WordsLikeSplit)
+{
+   for (std::string const line : {"hello big world", "", "a  b", "\ta b ", "single"})
+   {
+      std::vector<std::string> expected;
+      boost::split(expected, line, boost::is_any_of("\t "));
+      EXPECT_EQ(expected, splitAll(line));
+      EXPECT_EQ(expected.size(), Words(line).size());
+   }
+
+   std::ostringstream os;
+   os << Words("a b");
+   EXPECT_EQ("[a, b]", os.str());
+}
+
+TEST(Stream, EachLine)
+{
+   std::istringstream is("one\ntwo words\nand three words");
+   std::vector<size_t> counts;
+   auto const pipeline(Lazy()
+      | [](boost::string_view v) { return Words(v); }
+      | [](Words const& v) { return v.size(); }
+      | [&](size_t c) { counts.push_back(c); });
+
+   EXPECT_EQ(3u, Lines(is, 8) | each(pipeline));
+   EXPECT_EQ((std::vector<size_t>{1, 2, 3}), counts);
+}
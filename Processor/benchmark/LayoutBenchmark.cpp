@@ -0,0 +1,67 @@
+#include "../include/Processor.h"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <future>
+#include <string>
+
+/** The layout of the queues and processors depends on CacheLineSize, 
+ *  compare ProcessorBenchmark with ProcessorBenchmarkUnpadded, which 
+ *  is built with PROCESSOR_CACHE_LINE_SIZE=1. The label shows the size.
+ * */
+void Label( benchmark::State& state )
+{  state.SetLabel( "CacheLineSize=" + std::to_string( CacheLineSize ) ); }
+
+/** One producer thread pushing while the calling thread pops, 
+ *  so the producer and consumer fields are written concurrently.
+ * */
+template < typename QueueT >
+void Handoff( benchmark::State& state )
+{
+   auto const count( static_cast< int >( state.range( 0 ) ) );
+   while ( state.KeepRunning() )
+   {
+      QueueT queue;
+      auto producer( std::async( std::launch::async, [ &queue, count ]
+      {
+         for ( int i( 0 ); i < count; ++i )
+         {  queue.Push( std::move( i ) ); }
+      } ) );
+      for ( int i( 0 ); i < count; ++i )
+      {  benchmark::DoNotOptimize( queue.PopOrWait( std::chrono::seconds( 1 ) ) ); }
+      producer.get();
+   }
+   state.SetItemsProcessed( state.iterations() * count );
+   Label( state );
+}
+
+/** Items passing a chain of stages, where the layout of the
+ *  queues and the processor state is what matters.
+ * */
+template < typename LinkT >
+void Chain( benchmark::State& state )
+{
+   auto const count( static_cast< int >( state.range( 0 ) ) );
+   while ( state.KeepRunning() )
+   {
+      std::atomic< int > sum( 0 );
+      DataProcessor< int, int, LinkT > a( 1, []( int i ) { return i + 1; } );
+      ContinuationDataProcessor< int, int, LinkT > b( 1, a, []( std::future< int > i ) { return i.get() * 2; } );
+      TerminationProcessor< int > c( b, [ &sum ]( std::future< int > i ) { sum += i.get(); } );
+      for ( int i( 0 ); i < count; ++i )
+      {  a.Push( std::move( i ) ); }
+      a.Cancel();
+      c.Wait();
+      benchmark::DoNotOptimize( sum.load() );
+   }
+   state.SetItemsProcessed( state.iterations() * count );
+   Label( state );
+}
+
+BENCHMARK_TEMPLATE( Handoff, Queue< int > )->Arg( 1000000 )->UseRealTime();
+BENCHMARK_TEMPLATE( Handoff, MpscQueue< int > )->Arg( 1000000 )->UseRealTime();
+BENCHMARK_TEMPLATE( Handoff, SpscQueue< int > )->Arg( 1000000 )->UseRealTime();
+
+BENCHMARK_TEMPLATE( Chain, MpmcLink )->Arg( 100000 )->UseRealTime();
+BENCHMARK_TEMPLATE( Chain, SpscLink )->Arg( 100000 )->UseRealTime();
@@ -0,0 +1,173 @@
+
+#include "../include/Processor.h"
+#include "../include/PersistentQueue.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+#include <future>
+#include <chrono>
+#include <string>
+
+#include <dirent.h>
+#include <unistd.h>
+
+/** Moves state.range( 0 ) items from each of state.range( 1 ) producer 
+ *  threads to the consumer, the calling thread, like between two stages.
+ * */
+template < typename QueueT >
+void ProducerConsumer( benchmark::State& state )
+{
+   auto const count( static_cast< int >( state.range( 0 ) ) );
+   auto const producerCount( static_cast< int >( state.range( 1 ) ) );
+   while ( state.KeepRunning() )
+   {
+      QueueT queue;
+      std::vector< std::future< void > > producers;
+      for ( int p( 0 ); p < producerCount; ++p )
+      {
+         producers.emplace_back( std::async( std::launch::async, [ &queue, count ]
+         {
+            for ( int i( 0 ); i < count; ++i )
+            {  queue.Push( std::move( i ) ); }
+         } ) );
+      }
+      for ( int i( 0 ); i < count * producerCount; ++i )
+      {  benchmark::DoNotOptimize( queue.PopOrWait( std::chrono::seconds( 1 ) ) ); }
+      for ( auto& producer : producers ) { producer.get(); }
+   }
+   state.SetItemsProcessed( state.iterations() * count * producerCount );
+}
+
+/** Same as above but batched like the handoff between stages */
+template < typename QueueT >
+void ProducerConsumerBatch( benchmark::State& state )
+{
+   auto const count( static_cast< int >( state.range( 0 ) ) );
+   auto const batchSize( static_cast< size_t >( state.range( 1 ) ) );
+   while ( state.KeepRunning() )
+   {
+      QueueT queue;
+      auto producer( std::async( std::launch::async, [ &queue, count ]
+      {
+         for ( int i( 0 ); i < count; ++i )
+         {  queue.Push( std::move( i ) ); }
+      } ) );
+      std::vector< int > batch;
+      batch.reserve( batchSize );
+      for ( int i( 0 ); i < count; )
+      {
+         i += queue.PopBatchOrWait( batch, batchSize, std::chrono::seconds( 1 ) );
+         batch.clear();
+      }
+      producer.get();
+   }
+   state.SetItemsProcessed( state.iterations() * count );
+}
+
+/** Each of state.range( 1 ) producer threads pushes state.range( 0 ) items 
+ *  into two queues like a stage pushes a task and its future. Either the 
+ *  mutex of the second queue is taken nested in the critical section of 
+ *  the first one, or both queues share a single mutex.
+ * */
+template < bool Shared >
+void PairPush( benchmark::State& state )
+{
+   auto const count( static_cast< int >( state.range( 0 ) ) );
+   auto const producerCount( static_cast< int >( state.range( 1 ) ) );
+   while ( state.KeepRunning() )
+   {
+      Queue< int > output;
+      Queue< int > input( Shared ? &output.Mutex() : nullptr );
+      std::vector< std::future< void > > producers;
+      for ( int p( 0 ); p < producerCount; ++p )
+      {
+         producers.emplace_back( std::async( std::launch::async, [ &input, &output, count ]
+         {
+            for ( int i( 0 ); i < count; ++i )
+            {
+               input.Push( int( i ), [ &output, i ]
+               {
+                  if ( Shared ) { output.PushLocked( int( i ) ); }
+                  else          { output.Push( int( i ) ); }
+               } );
+            }
+         } ) );
+      }
+      for ( auto& producer : producers ) { producer.get(); }
+   }
+   state.SetItemsProcessed( state.iterations() * count * producerCount );
+}
+
+/** Tasks pushed by state.range( 1 ) producer threads into a stage, 
+ *  the results are taken by the calling thread
+ * */
+void TaskPush( benchmark::State& state )
+{
+   auto const count( static_cast< int >( state.range( 0 ) ) );
+   auto const producerCount( static_cast< int >( state.range( 1 ) ) );
+   while ( state.KeepRunning() )
+   {
+      BufferingTaskProcessor< int > processor( 1 );
+      std::vector< std::future< void > > producers;
+      for ( int p( 0 ); p < producerCount; ++p )
+      {
+         producers.emplace_back( std::async( std::launch::async, [ &processor, count ]
+         {
+            for ( int i( 0 ); i < count; ++i )
+            {  processor.Push( [ i ]{ return i; } ); }
+         } ) );
+      }
+      for ( int i( 0 ); i < count * producerCount; ++i )
+      {  benchmark::DoNotOptimize( processor.PopOrWait( std::chrono::seconds( 1 ) )->get() ); }
+      for ( auto& producer : producers ) { producer.get(); }
+   }
+   state.SetItemsProcessed( state.iterations() * count * producerCount );
+}
+
+/** Same as ProducerConsumer with a single producer, for the durable queue
+ *  syncing every state.range( 1 ) items, compare with Queue< int >.
+ * */
+void PersistentProducerConsumer( benchmark::State& state )
+{
+   auto const count( static_cast< int >( state.range( 0 ) ) );
+   auto const syncInterval( static_cast< size_t >( state.range( 1 ) ) );
+   char path[] = "/tmp/PersistentQueueBenchmark-XXXXXX";
+   std::string const directory( mkdtemp( path ) );
+   while ( state.KeepRunning() )
+   {
+      PersistentQueue< int > queue( directory, 1 << 16, syncInterval );
+      auto producer( std::async( std::launch::async, [ &queue, count ]
+      {
+         for ( int i( 0 ); i < count; ++i )
+         {  queue.Push( std::move( i ) ); }
+      } ) );
+      for ( int i( 0 ); i < count; ++i )
+      {  benchmark::DoNotOptimize( queue.PopOrWait( std::chrono::seconds( 1 ) ) ); }
+      producer.get();
+   }
+   state.SetItemsProcessed( state.iterations() * count );
+
+   if ( auto d = opendir( directory.c_str() ) )
+   {
+      while ( auto entry = readdir( d ) )
+      {  unlink( ( directory + "/" + entry->d_name ).c_str() ); }
+      closedir( d );
+   }
+   rmdir( directory.c_str() );
+}
+
+BENCHMARK_TEMPLATE( ProducerConsumer, Queue< int > )->Args( { 100000, 1 } )->Args( { 25000, 4 } )->UseRealTime();
+BENCHMARK_TEMPLATE( ProducerConsumer, SpscQueue< int > )->Args( { 100000, 1 } )->UseRealTime();
+BENCHMARK_TEMPLATE( ProducerConsumer, MpscQueue< int > )->Args( { 100000, 1 } )->Args( { 25000, 4 } )->UseRealTime();
+
+BENCHMARK_TEMPLATE( ProducerConsumerBatch, Queue< int > )->Args( { 100000, 64 } )->UseRealTime();
+BENCHMARK_TEMPLATE( ProducerConsumerBatch, SpscQueue< int > )->Args( { 100000, 64 } )->UseRealTime();
+BENCHMARK_TEMPLATE( ProducerConsumerBatch, MpscQueue< int > )->Args( { 100000, 64 } )->UseRealTime();
+
+BENCHMARK_TEMPLATE( PairPush, false )->Args( { 100000, 1 } )->Args( { 25000, 4 } )->UseRealTime();
+BENCHMARK_TEMPLATE( PairPush, true )->Args( { 100000, 1 } )->Args( { 25000, 4 } )->UseRealTime();
+
+BENCHMARK( TaskPush )->Args( { 100000, 1 } )->Args( { 25000, 4 } )->UseRealTime();
+
+BENCHMARK( PersistentProducerConsumer )->Args( { 100000, 1024 } )->Args( { 100000, 1 << 20 } )->UseRealTime();
@@ -0,0 +1,209 @@
+#pragma once
+
+#include "Processor.h"
+
+#include <vector>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <exception>
+
+template < typename QueueT, typename OutputQueueT, typename T >
+struct BatchingWorker
+{
+   typedef std::chrono::steady_clock clock_type;
+   
+   BatchingWorker( std::atomic< bool >& canceled, CancellationSource& cancellation, QueueT& queue, OutputQueueT& output, size_t maxCount, clock_type::duration maxDelay ) : 
+       m_canceled( canceled )
+      ,m_cancellation( cancellation )
+      ,m_queue( queue )
+      ,m_output( output )
+      ,m_maxCount( maxCount )
+      ,m_maxDelay( maxDelay )
+      ,m_batch()
+      ,m_deadline()
+      ,m_pending()
+   {}
+   
+   /** The futures of the predecessor are taken in order but only when they are ready, 
+    *  waiting for them with the remaining time of the batch. So a slow item does not 
+    *  delay the batch of the items before it, it is added to the next one.
+    * */
+   void operator()()
+   {
+      m_batch.reserve( m_maxCount );
+      while ( !m_canceled.load() ) ///< When we got canceled directly, we just stop working here
+      {
+         if ( !m_pending.valid() )
+         {
+            if ( m_queue.IsCanceled() ) ///< Predecessor is canceled, we takeover all results and cancel then as well
+            {
+               auto item( m_queue.Pop() ); ///< Without wait, because new items cannot be added anymore
+               if ( !item ) { break; }
+               m_pending = std::move( item.value() );
+            }
+            else
+            {
+               /** The timeout here avoids a deadlock when between 
+                *  IsCanceled and Pop the internal queue state changes
+                *  and bounds the latency of the first item in a batch
+                * */
+               auto item( m_queue.PopOrWait( Timeout() ) );
+               if ( item ) 
+               {  m_pending = std::move( item.value() ); }
+            }
+         }
+         if ( m_pending.valid() && m_pending.wait_for( Timeout() ) != std::future_status::timeout )
+         {  Add( std::move( m_pending ) ); }
+         if ( !m_batch.empty() && clock_type::now() >= m_deadline )
+         {  Emit(); }
+      }
+      if ( m_cancellation.IsCanceled() ) ///< Discarded, the items not collected yet are counted instead of dropped silently
+      {
+         if ( m_pending.valid() )
+         {
+            m_pending = std::future< T >();
+            m_cancellation.CountDiscarded();
+         }
+         while ( m_queue.Pop() )
+         {  m_cancellation.CountDiscarded(); }
+      }
+      else if ( m_pending.valid() ) ///< Drained, the item already taken from the predecessor is waited for and provided
+      {  Add( std::move( m_pending ) ); }
+      Emit();
+      m_output.Cancel(); ///< We cancel the queue not until here when the thread finishes
+   }
+   
+private:
+   clock_type::duration Timeout() const
+   {
+      return m_batch.empty() 
+         ? clock_type::duration( std::chrono::seconds( 1 ) ) 
+         : std::max( clock_type::duration::zero(), m_deadline - clock_type::now() );
+   }
+   
+   void Add( std::future< T > future )
+   {
+      try
+      {
+         m_batch.emplace_back( future.get() );
+         if ( m_batch.size() == 1 )
+         {  m_deadline = clock_type::now() + m_maxDelay; }
+         if ( m_batch.size() >= m_maxCount )
+         {  Emit(); }
+      }
+      catch ( ... )
+      {
+         /** Failed items are forwarded as batch of their own to keep the order */
+         Emit();
+         std::promise< std::vector< T > > promise( std::allocator_arg, PoolAllocator< std::vector< T > >() );
+         promise.set_exception( std::current_exception() );
+         m_output.Push( promise.get_future() );
+      }
+   }
+   
+   void Emit()
+   {
+      if ( m_batch.empty() )
+      {  return; }
+      
+      std::promise< std::vector< T > > promise( std::allocator_arg, PoolAllocator< std::vector< T > >() );
+      promise.set_value( std::move( m_batch ) );
+      m_output.Push( promise.get_future() );
+      m_batch = std::vector< T >();
+      m_batch.reserve( m_maxCount );
+   }
+   
+   std::atomic< bool >& m_canceled;
+   CancellationSource& m_cancellation;
+   QueueT& m_queue;
+   OutputQueueT& m_output;
+   size_t const m_maxCount;
+   clock_type::duration const m_maxDelay;
+   std::vector< T > m_batch;
+   clock_type::time_point m_deadline;
+   std::future< T > m_pending; ///< Next item of the predecessor, not ready yet
+};
+
+/** Collects the results of its predecessor into batches, a batch 
+ *  is provided when it reaches maxCount items or when maxDelay has 
+ *  passed since its first item arrived, also while the next item 
+ *  is still being processed. A failing item is provided 
+ *  as failed batch of its own, right after the items before it.
+ * */
+template < typename T >
+struct BatchingProcessor : ProcessorBase< std::future< std::vector< T > > >
+{
+   typedef std::vector< T > batch_type;
+   typedef ProcessorBase< std::future< batch_type > > base_type;
+   typedef typename base_type::queue_type output_queue_type;
+   
+   using base_type::Pop;
+   using base_type::PopOrWait;
+   
+   template < typename PredecessorT >
+   BatchingProcessor( PredecessorT& predecessor, size_t maxCount, std::chrono::steady_clock::duration maxDelay ) :
+       base_type()
+      ,m_canceled( false )
+      ,m_cancellation()
+      ,m_worker()
+   {
+      if ( maxCount == 0 )
+      {  throw std::invalid_argument( "Batch size cannot equal 0" ); }
+      
+      m_worker = std::async( 
+          std::launch::async
+         ,BatchingWorker< typename PredecessorT::output_queue_type, output_queue_type, T >( 
+             m_canceled
+            ,m_cancellation
+            ,predecessor.m_output
+            ,this->m_output
+            ,maxCount
+            ,maxDelay ) );
+   }
+   
+   ~BatchingProcessor()
+   {
+      Cancel();
+      Wait();
+   }
+   
+   /** Already collected items are provided as last batch. With Discard the
+    *  items not collected yet are taken from the predecessor and counted.
+    * */
+   void Cancel( CancelMode mode = CancelMode::Drain )
+   {
+      if ( mode == CancelMode::Discard )
+      {  m_cancellation.Cancel(); } ///< Before the flag, so the worker sees it when it leaves
+      m_canceled.store( true );
+   }
+   
+   void Wait()
+   {
+      /** This is not thread save */
+      if ( m_worker.valid() )
+      {  m_worker.get(); }
+   }
+   
+   /** Joins the worker thread when it is finished within the duration */
+   template < typename DurationType >
+   bool WaitFor( DurationType duration )
+   {
+      if ( m_worker.valid() && m_worker.wait_for( duration ) != std::future_status::ready )
+      {  return false; }
+      Wait();
+      return true;
+   }
+   
+   /** Number of batches not taken yet */
+   size_t Pending() const
+   {  return this->m_output.Size(); }
+   
+   size_t DiscardedCount() const
+   {  return m_cancellation.DiscardedCount(); }
+   
+private:
+   std::atomic< bool > m_canceled;
+   CancellationSource m_cancellation;
+   std::future< void > m_worker;
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <boost/optional/optional.hpp>
+
+#include <exception>
+#include <stdexcept>
+#include <utility>
+#include <type_traits>
+
+template < typename E >
+struct Unexpected
+{
+   explicit Unexpected( E error ) : m_error( std::move( error ) ) {}
+   
+   E m_error;
+};
+
+template < typename E >
+Unexpected< std::decay_t< E > > MakeUnexpected( E&& error )
+{  return Unexpected< std::decay_t< E > >( std::forward< E >( error ) ); }
+
+namespace
+{
+   /** Accessing the value of an Expected holding an exception 
+    *  rethrows it, like std::future::get() would do.
+    * */
+   inline void ThrowError( std::exception_ptr const& error )
+   {  std::rethrow_exception( error ); }
+   
+   template < typename E >
+   void ThrowError( E const& )
+   {  throw std::logic_error( "Expected holds an error" ); }
+}
+
+/** Either a value or an error, used to pass errors through 
+ *  processors as plain values instead of thrown exceptions.
+ * */
+template < typename T, typename E = std::exception_ptr >
+struct Expected
+{
+   typedef T value_type;
+   typedef E error_type;
+   
+   Expected( T value ) : m_value( std::move( value ) ), m_error() {}
+   
+   template < typename G >
+   Expected( Unexpected< G > error ) : m_value(), m_error( std::move( error.m_error ) ) {}
+   
+   bool HasValue() const
+   {  return (bool)m_value; }
+   
+   explicit operator bool() const
+   {  return HasValue(); }
+   
+   T& Value() &
+   {
+      if ( !m_value ) { ThrowError( m_error ); }
+      return *m_value;
+   }
+   
+   T const& Value() const&
+   {
+      if ( !m_value ) { ThrowError( m_error ); }
+      return *m_value;
+   }
+   
+   T&& Value() &&
+   {
+      if ( !m_value ) { ThrowError( m_error ); }
+      return std::move( *m_value );
+   }
+   
+   /** Valid when HasValue() is false only */
+   E const& Error() const
+   {  return m_error; }
+   
+private:
+   boost::optional< T > m_value;
+   E m_error;
+};
+
+template < typename E >
+struct Expected< void, E >
+{
+   typedef void value_type;
+   typedef E error_type;
+   
+   Expected() : m_hasValue( true ), m_error() {}
+   
+   template < typename G >
+   Expected( Unexpected< G > error ) : m_hasValue( false ), m_error( std::move( error.m_error ) ) {}
+   
+   bool HasValue() const
+   {  return m_hasValue; }
+   
+   explicit operator bool() const
+   {  return HasValue(); }
+   
+   void Value() const
+   {
+      if ( !m_hasValue ) { ThrowError( m_error ); }
+   }
+   
+   /** Valid when HasValue() is false only */
+   E const& Error() const
+   {  return m_error; }
+   
+private:
+   bool m_hasValue;
+   E m_error;
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Processor.h"
+#include "Expected.h"
+
+#include <future>
+#include <exception>
+#include <functional>
+
+namespace
+{
+   template < typename OutputT, typename E, typename FunctionT, typename... ArgumentT >
+   Expected< OutputT, E > InvokeExpected( std::false_type, FunctionT const& function, ArgumentT&&... arguments )
+   {  return function( std::forward< ArgumentT >( arguments )... ); }
+   
+   template < typename OutputT, typename E, typename FunctionT, typename... ArgumentT >
+   Expected< OutputT, E > InvokeExpected( std::true_type, FunctionT const& function, ArgumentT&&... arguments )
+   {
+      try 
+      {  return function( std::forward< ArgumentT >( arguments )... ); }
+      catch ( ... )
+      {  return MakeUnexpected( std::current_exception() ); }
+   }
+   
+   template < typename OutputT, typename E, typename FunctionT, typename DeadLetterFunctionT, typename... ArgumentT >
+   Expected< OutputT, E > CallExpected( FunctionT const& function, DeadLetterFunctionT const& deadLetter, ArgumentT&&... arguments )
+   {
+      auto result( InvokeExpected< OutputT, E >( std::is_same< std::exception_ptr, E >(), function, std::forward< ArgumentT >( arguments )... ) );
+      if ( !result && deadLetter )
+      {  deadLetter( result.Error() ); }
+      return result;
+   }
+   
+   /** Exceptions stored in the future become errors and are dead lettered, 
+    *  since the plain predecessor storing them has no dead letter function.
+    * */
+   template < typename InputT, typename E, typename DeadLetterFunctionT >
+   Expected< InputT, E > GetExpected( std::false_type, std::future< Expected< InputT, E > >& future, DeadLetterFunctionT const& )
+   {  return future.get(); }
+   
+   template < typename InputT, typename E, typename DeadLetterFunctionT >
+   Expected< InputT, E > GetExpected( std::true_type, std::future< Expected< InputT, E > >& future, DeadLetterFunctionT const& deadLetter )
+   {
+      try 
+      {  return future.get(); }
+      catch ( ... )
+      {
+         Expected< InputT, E > result( MakeUnexpected( std::current_exception() ) );
+         if ( deadLetter )
+         {  deadLetter( result.Error() ); }
+         return result;
+      }
+   }
+}
+
+/** Stages passing errors as values of Expected through the futures 
+ *  instead of exceptions. Exceptions thrown by the functions or stored 
+ *  in the futures of a predecessor are converted once into errors when 
+ *  the error type is std::exception_ptr, failed items are forwarded 
+ *  without calling the function. 
+ *  The optional dead letter function is called for each item failing 
+ *  in the stage it is given to, including exceptions of a plain predecessor 
+ *  converted there, but not for the forwarded failures. It is called 
+ *  concurrently from the worker threads and has to be thread-safe.
+ * */
+template < typename InputT, typename OutputT, typename E = std::exception_ptr >
+struct ExpectedDataProcessor : DataProcessor< InputT, Expected< OutputT, E > >
+{
+   typedef Expected< OutputT, E > result_type;
+   typedef DataProcessor< InputT, result_type > base_type;
+   typedef std::function< result_type( InputT&& ) > function_type;
+   typedef std::function< void( E const& ) > dead_letter_function_type;
+   
+   using base_type::Cancel;
+   using base_type::Wait;
+   using base_type::Pop;
+   using base_type::PopOrWait;
+   using base_type::Push;
+   
+   /** deadLetter is called concurrently by the workerCount threads */
+   ExpectedDataProcessor( size_t workerCount, function_type function, dead_letter_function_type deadLetter = dead_letter_function_type() ) :
+      base_type( workerCount, typename base_type::function_type( [ function, deadLetter ]( InputT&& input )
+      {  return CallExpected< OutputT, E >( function, deadLetter, std::move( input ) ); } ) )
+   {}
+};
+
+template < typename InputT, typename OutputT, typename E = std::exception_ptr >
+struct ExpectedContinuationDataProcessor : ContinuationDataProcessor< Expected< InputT, E >, Expected< OutputT, E > >
+{
+   typedef Expected< InputT, E > input_type;
+   typedef Expected< OutputT, E > result_type;
+   typedef ContinuationDataProcessor< input_type, result_type > base_type;
+   typedef std::function< result_type( InputT&& ) > function_type;
+   typedef std::function< void( E const& ) > dead_letter_function_type;
+   
+   using base_type::Cancel;
+   using base_type::Wait;
+   using base_type::Pop;
+   using base_type::PopOrWait;
+   
+   /** deadLetter is called concurrently by the workerCount threads, for errors 
+    *  of function and for exceptions stored in the futures of predecessor
+    * */
+   template < typename PredecessorT >
+   ExpectedContinuationDataProcessor( size_t workerCount, PredecessorT& predecessor, function_type function, dead_letter_function_type deadLetter = dead_letter_function_type() ) :
+      base_type( workerCount, predecessor, typename base_type::function_type( [ function, deadLetter ]( std::future< input_type >&& future )
+      {
+         auto input( GetExpected( std::is_same< std::exception_ptr, E >(), future, deadLetter ) );
+         if ( !input ) ///< Failed before, forward the error without calling the function
+         {  return result_type( MakeUnexpected( input.Error() ) ); }
+         return CallExpected< OutputT, E >( function, deadLetter, std::move( input ).Value() );
+      } ) )
+   {}
+};
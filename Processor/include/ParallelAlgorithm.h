@@ -0,0 +1,196 @@
+#pragma once
+
+#include "Processor.h"
+
+#include <boost/optional/optional.hpp>
+
+#include <vector>
+#include <future>
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <utility>
+
+namespace
+{
+   auto const TargetChunkDuration( std::chrono::microseconds( 100 ) );
+   auto const ProbeDuration( std::chrono::microseconds( 10 ) );
+   size_t const ChunksPerWorker( 4 ); ///< Some more chunks than workers compensate unequal item costs
+
+   template < typename ResultT >
+   std::vector< ResultT > JoinChunks( std::vector< std::future< void > >& futures, std::vector< boost::optional< ResultT > >& results, std::exception_ptr error )
+   {
+      /** All futures have to be joined before anything is thrown,
+       *  because the tasks refer to the data of the caller
+       * */
+      for ( auto& future : futures )
+      {
+         try { future.get(); }
+         catch ( ... )
+         {
+            if ( !error ) { error = std::current_exception(); }
+         }
+      }
+      if ( error )
+      {  std::rethrow_exception( error ); }
+
+      std::vector< ResultT > r;
+      r.reserve( results.size() );
+      for ( auto& result : results )
+      {  r.emplace_back( std::move( result.value() ) ); }
+      return r;
+   }
+
+   /** Calls chunk( begin, end ) for consecutive index ranges covering [0, count)
+    *  and returns the results of all calls in the order of the ranges.
+    * */
+   template < typename ChunkFunctionT >
+   auto ParallelChunks( TaskProcessor<>& processor, size_t count, size_t grainSize, ChunkFunctionT const& chunk )
+   {
+      typedef decltype( chunk( size_t(), size_t() ) ) result_type;
+      std::vector< boost::optional< result_type > > results;
+
+      size_t begin( 0 );
+      if ( grainSize == 0 )
+      {
+         auto const start( std::chrono::steady_clock::now() );
+         auto elapsed( std::chrono::steady_clock::duration::zero() );
+         for ( size_t size( 1 ); begin < count && elapsed < ProbeDuration; size *= 2 )
+         {
+            auto const end( std::min( count, begin + size ) );
+            results.emplace_back( chunk( begin, end ) );
+            begin = end;
+            elapsed = std::chrono::steady_clock::now() - start;
+         }
+         auto const itemsPerChunk( std::chrono::duration< double >( TargetChunkDuration ).count()
+                                 * begin / std::max( std::chrono::duration< double >( elapsed ).count(), 1e-9 ) );
+         grainSize = static_cast< size_t >( std::max( 1., itemsPerChunk ) );
+      }
+
+      auto const rest( count - begin );
+      auto const workerCount( processor.WorkerCount() );
+      if ( rest <= grainSize || workerCount == 0 )
+      {
+         if ( rest > 0 )
+         {  results.emplace_back( chunk( begin, count ) ); }
+         std::vector< std::future< void > > none;
+         return JoinChunks( none, results, std::exception_ptr() );
+      }
+
+      auto const chunkSize( std::max( grainSize, ( rest + workerCount * ChunksPerWorker - 1 ) / ( workerCount * ChunksPerWorker ) ) );
+      auto slot( results.size() );
+      results.resize( slot + ( rest + chunkSize - 1 ) / chunkSize ); ///< Before the first push, the tasks write into it
+
+      std::vector< std::future< void > > futures;
+      std::exception_ptr error;
+      try
+      {
+         for ( ; count - begin > chunkSize; begin += chunkSize, ++slot )
+         {
+            futures.emplace_back( processor.Push( [ &chunk, &results, begin, chunkSize, slot ]
+            {  results[ slot ] = chunk( begin, begin + chunkSize ); } ) );
+         }
+         results[ slot ] = chunk( begin, count ); ///< The last chunk is processed by the caller
+      }
+      catch ( ... )
+      {  error = std::current_exception(); }
+      return JoinChunks( futures, results, error );
+   }
+
+   template < typename IteratorT >
+   void RequireRandomAccess()
+   {
+      static_assert( std::is_same< std::random_access_iterator_tag, typename std::iterator_traits< IteratorT >::iterator_category >::value
+                   , "Parallel algorithms require random access iterators" );
+   }
+}
+
+/** Algorithms running on the workers of an existing TaskProcessor.
+ *  The calling thread processes a chunk as well instead of idling,
+ *  so they must not be called from a task of the same processor.
+ *
+ *  When grainSize is 0, the number of items per chunk is tuned at
+ *  runtime: A growing prefix of the input is processed inline until
+ *  the cost per item is known, then chunks get sized so that each one
+ *  takes at least TargetChunkDuration. Small or cheap inputs are
+ *  therefore processed completely inline without any scheduling.
+ * */
+template < typename IteratorT, typename FunctionT >
+void ParallelFor( TaskProcessor<>& processor, IteratorT first, IteratorT last, FunctionT function, size_t grainSize = 0 )
+{
+   RequireRandomAccess< IteratorT >();
+   ParallelChunks( processor, std::distance( first, last ), grainSize, [ first, &function ]( size_t begin, size_t end )
+   {
+      std::for_each( first + begin, first + end, function );
+      return end - begin;
+   } );
+}
+
+template < typename InputIteratorT, typename OutputIteratorT, typename FunctionT >
+OutputIteratorT ParallelTransform( TaskProcessor<>& processor, InputIteratorT first, InputIteratorT last, OutputIteratorT output, FunctionT function, size_t grainSize = 0 )
+{
+   RequireRandomAccess< InputIteratorT >();
+   RequireRandomAccess< OutputIteratorT >();
+   auto const count( std::distance( first, last ) );
+   ParallelChunks( processor, count, grainSize, [ first, output, &function ]( size_t begin, size_t end )
+   {
+      std::transform( first + begin, first + end, output + begin, function );
+      return end - begin;
+   } );
+   return output + count;
+}
+
+/** Partial results are combined in order of the input,
+ *  so the operation has to be associative, it need not be commutative.
+ * */
+template < typename IteratorT, typename T, typename OperationT = std::plus<> >
+T ParallelReduce( TaskProcessor<>& processor, IteratorT first, IteratorT last, T init, OperationT operation = OperationT(), size_t grainSize = 0 )
+{
+   RequireRandomAccess< IteratorT >();
+   auto const partials( ParallelChunks( processor, std::distance( first, last ), grainSize, [ first, &operation ]( size_t begin, size_t end )
+   {
+      T partial( *( first + begin ) );
+      return std::accumulate( first + begin + 1, first + end, std::move( partial ), operation );
+   } ) );
+   return std::accumulate( partials.begin(), partials.end(), std::move( init ), operation );
+}
+
+/** Chunks are sorted in parallel and merged pairwise
+ *  afterwards, every merge round is done in parallel as well.
+ * */
+template < typename IteratorT, typename CompareT = std::less<> >
+void ParallelSort( TaskProcessor<>& processor, IteratorT first, IteratorT last, CompareT compare = CompareT(), size_t grainSize = 0 )
+{
+   RequireRandomAccess< IteratorT >();
+   auto runs( ParallelChunks( processor, std::distance( first, last ), grainSize, [ first, &compare ]( size_t begin, size_t end )
+   {
+      std::sort( first + begin, first + end, compare );
+      return std::make_pair( begin, end );
+   } ) );
+
+   while ( runs.size() > 1 )
+   {
+      auto const merged( ParallelChunks( processor, runs.size() / 2, 1, [ first, &compare, &runs ]( size_t begin, size_t end )
+      {
+         std::vector< std::pair< size_t, size_t > > r;
+         for ( auto pair( begin ); pair < end; ++pair )
+         {
+            auto const& left( runs[ 2 * pair ] );
+            auto const& right( runs[ 2 * pair + 1 ] );
+            std::inplace_merge( first + left.first, first + left.second, first + right.second, compare );
+            r.emplace_back( left.first, right.second );
+         }
+         return r;
+      } ) );
+
+      std::vector< std::pair< size_t, size_t > > next;
+      for ( auto const& chunk : merged )
+      {  next.insert( next.end(), chunk.begin(), chunk.end() ); }
+      if ( runs.size() % 2 == 1 )
+      {  next.emplace_back( runs.back() ); }
+      runs.swap( next );
+   }
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include "Processor.h"
+
+#include <vector>
+#include <future>
+#include <memory>
+#include <atomic>
+#include <functional>
+
+template < typename QueueT, typename OutputQueueT >
+struct PartitionWorker
+{
+   PartitionWorker( QueueT& queue, OutputQueueT& output, std::atomic< size_t >& running ) : m_queue( queue ), m_output( output ), m_running( running ) {}
+   
+   void operator()()
+   {
+      while ( !m_queue.IsCanceled() )
+      {
+         /** The timeout here avoids a deadlock when between 
+          *  IsCanceled and Pop the internal queue state changes
+          * */
+         auto item( m_queue.PopOrWait( std::chrono::seconds( 1 ) ) );
+         if ( item ) { Process( std::move( item.value() ) ); }
+      }
+      while ( 1 ) ///< Canceled but we finish all enqueued work before we leave
+      {
+         auto item( m_queue.Pop() ); ///< Without wait, there cannot be new items, we only take what is already there
+         if ( !item ) { break; }
+         Process( std::move( item.value() ) );
+      }
+      if ( --m_running == 0 ) 
+      {  m_output.Cancel(); } ///< The last lane cancels the output, not until all results are in
+   }
+   
+private:
+   template < typename TaskT >
+   void Process( TaskT task )
+   {
+      auto future( task.get_future() );
+      task();
+      m_output.Push( std::move( future ) );
+   }
+   
+   QueueT& m_queue;
+   OutputQueueT& m_output;
+   std::atomic< size_t >& m_running;
+};
+
+/** Data processor with one worker per lane, items are assigned to a 
+ *  lane by the hash of their key. Items with the same key are processed 
+ *  in order of their push and always by the same worker, items with 
+ *  different keys are processed in parallel. 
+ *  Results are provided in order of their completion, so the order 
+ *  is kept per key only.
+ *  Each lane has a single consumer, its worker, so lanes are MpscQueues.
+ *  The results are pushed by all lane workers, use MpscLink when they 
+ *  are taken by a single thread like a successor stage only.
+ * */
+template < typename KeyT, typename InputT, typename OutputT = void, typename HashT = std::hash< KeyT >, typename LinkT = MpmcLink >
+struct PartitionedDataProcessor : ProcessorBase< std::future< OutputT >, typename LinkQueue< LinkT, std::future< OutputT > >::type >
+{
+   typedef ProcessorBase< std::future< OutputT >, typename LinkQueue< LinkT, std::future< OutputT > >::type > base_type;
+   typedef typename base_type::queue_type output_queue_type;
+   typedef MpscQueue< PooledTask< OutputT > > lane_queue_type;
+   typedef std::function< KeyT( InputT const& ) > key_function_type;
+   typedef std::function< OutputT( InputT&& ) > function_type;
+   typedef std::function< OutputT( InputT&&, CancellationToken const& ) > cancelable_function_type;
+   
+   static_assert( QueueConcurrency< output_queue_type >::MultipleProducers, "All lane workers push results, SpscLink is not supported" );
+   
+   using base_type::Pop;
+   using base_type::PopOrWait;
+   
+   PartitionedDataProcessor( size_t laneCount, key_function_type key, function_type function ) :
+      PartitionedDataProcessor( laneCount, std::move( key ), cancelable_function_type( [ function ]( InputT&& data, CancellationToken const& ) 
+      {  return function( std::move( data ) ); } ) )
+   {}
+   
+   PartitionedDataProcessor( size_t laneCount, key_function_type key, cancelable_function_type function ) :
+       base_type()
+      ,m_key( std::move( key ) )
+      ,m_hash()
+      ,m_function( std::move( function ) )
+      ,m_cancellation()
+      ,m_running( laneCount )
+      ,m_lanes()
+      ,m_worker()
+   {
+      if ( laneCount == 0 )
+      {  throw std::invalid_argument( "Lane count cannot equal 0" ); }
+      
+      for ( size_t i( 0 ); i < laneCount; ++i )
+      {
+         m_lanes.emplace_back( std::make_unique< lane_queue_type >() );
+         m_worker.emplace_back( std::async( 
+             std::launch::async
+            ,PartitionWorker< lane_queue_type, output_queue_type >( *m_lanes.back(), this->m_output, m_running ) ) );
+      }
+   }
+   
+   ~PartitionedDataProcessor()
+   {
+      Cancel();
+      Wait();
+   }
+   
+   void Push( InputT&& data )
+   {
+      auto& lane( *m_lanes[ m_hash( m_key( data ) ) % m_lanes.size() ] );
+      auto task( MakeTask< OutputT >( MakeCancelable( 
+          std::bind( std::cref( m_function ), std::bind( std::move< InputT& >, std::move( data ) ), std::placeholders::_1 )
+         ,m_cancellation ) ) );
+      lane.Push( std::move( task ) );
+   }
+   
+   /** The output gets canceled by the last lane worker, 
+    *  when all enqueued items are processed.
+    * */
+   void Cancel( CancelMode mode = CancelMode::Drain )
+   {
+      auto lock( this->Lock() );
+      if ( mode == CancelMode::Discard )
+      {  m_cancellation.Cancel(); }
+      for ( auto& lane : m_lanes )
+      {  lane->Cancel(); }
+   }
+   
+   void Wait()
+   {
+      /** This is not thread save */
+      if ( !m_worker.empty() )
+      {  JoinWorker( std::move( m_worker ) ); }
+   }
+   
+   /** Joins the workers when they are finished within the duration */
+   template < typename DurationType >
+   bool WaitFor( DurationType duration )
+   {
+      if ( !WaitForWorker( m_worker, duration ) )
+      {  return false; }
+      Wait();
+      return true;
+   }
+   
+   /** Number of tasks in the lanes not started yet plus number of results not taken yet */
+   size_t Pending() const
+   {
+      size_t pending( this->m_output.Size() );
+      for ( auto const& lane : m_lanes )
+      {  pending += lane->Size(); }
+      return pending;
+   }
+   
+   size_t DiscardedCount() const
+   {  return m_cancellation.DiscardedCount(); }
+   
+   CancellationToken GetToken() const
+   {  return m_cancellation.GetToken(); }
+   
+private:
+   key_function_type const m_key;
+   HashT const m_hash;
+   cancelable_function_type const m_function;
+   CancellationSource m_cancellation;
+   std::atomic< size_t > m_running;
+   std::vector< std::unique_ptr< lane_queue_type > > m_lanes;
+   std::vector< std::future< void > > m_worker;
+};
@@ -0,0 +1,437 @@
+#pragma once
+
+#include "Processor.h"
+
+#include <boost/optional/optional.hpp>
+
+#include <mutex>
+#include <memory>
+#include <condition_variable>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <utility>
+#include <exception>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <cstdint>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace
+{
+   /** File of fixed size mapped into memory, created when missing */
+   struct MappedFile
+   {
+      MappedFile() : m_memory( nullptr ), m_size( 0 ) {}
+
+      MappedFile( std::string const& path, size_t size ) : m_memory( nullptr ), m_size( size )
+      {
+         auto const fd( open( path.c_str(), O_CREAT | O_RDWR, 0600 ) );
+         if ( fd == -1 )
+         {  throw std::system_error( errno, std::generic_category(), "Unable to open " + path ); }
+
+         struct stat s;
+         if ( fstat( fd, &s ) == -1 || ( static_cast< size_t >( s.st_size ) < size && ftruncate( fd, size ) == -1 ) )
+         {
+            auto const error( errno );
+            close( fd );
+            throw std::system_error( error, std::generic_category(), "Unable to size " + path );
+         }
+
+         auto const memory( mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 ) );
+         auto const error( errno );
+         close( fd );
+         if ( memory == MAP_FAILED )
+         {  throw std::system_error( error, std::generic_category(), "Unable to map " + path ); }
+         m_memory = static_cast< char* >( memory );
+      }
+
+      MappedFile( MappedFile&& other ) : m_memory( other.m_memory ), m_size( other.m_size )
+      {
+         other.m_memory = nullptr;
+         other.m_size = 0;
+      }
+
+      MappedFile& operator=( MappedFile&& other )
+      {
+         std::swap( m_memory, other.m_memory );
+         std::swap( m_size, other.m_size );
+         return *this;
+      }
+
+      ~MappedFile()
+      {
+         if ( m_memory != nullptr )
+         {  munmap( m_memory, m_size ); }
+      }
+
+      /** Writes the pages covering [begin, end) back to the file */
+      void Sync( size_t begin, size_t end )
+      {
+         if ( m_memory == nullptr || begin >= end ) { return; }
+
+         static size_t const pageSize( sysconf( _SC_PAGESIZE ) );
+         begin -= begin % pageSize;
+         if ( msync( m_memory + begin, end - begin, MS_SYNC ) == -1 )
+         {  throw std::system_error( errno, std::generic_category(), "Unable to sync mapped file" ); }
+      }
+
+      char* m_memory;
+      size_t m_size;
+   };
+}
+
+/** Durable queue of trivially copyable items, buffered items survive
+ *  a restart of the process. Items are appended to a log of memory
+ *  mapped segment files in directory, the position of the consumer is
+ *  kept in an offset file next to it. Segments are deleted when they
+ *  are consumed completely.
+ *
+ *  Pushing and popping costs a copy into and out of the page cache, so
+ *  a crash of the process loses nothing. To survive a crash of the host,
+ *  msync() is called for every syncInterval pushed items, for the items
+ *  and the offset together, or explicitly by Sync(). After such a crash,
+ *  items popped since the last sync are delivered again. The dirty range
+ *  is taken under the lock but written back without it, by the producer
+ *  passing the interval, so the others do not stall meanwhile.
+ * */
+template < typename T >
+struct PersistentQueue
+{
+   static_assert( std::is_trivially_copyable< T >::value, "Items of a persistent queue have to be trivially copyable" );
+
+   typedef T value_type;
+   typedef boost::optional< value_type > optional_value_type;
+
+   /** Resumes from the content of directory when there is some,
+    *  recordsPerSegment has to be the same as before then.
+    * */
+   PersistentQueue( std::string const& directory, size_t recordsPerSegment = 1 << 16, size_t syncInterval = 1024 ) :
+       m_directory( directory )
+      ,m_recordsPerSegment( recordsPerSegment )
+      ,m_syncInterval( syncInterval )
+      ,m_canceled( false )
+      ,m_offsetFile()
+      ,m_offset( nullptr )
+      ,m_read( 0 )
+      ,m_readSegment()
+      ,m_readIndex( 0 )
+      ,m_write( 0 )
+      ,m_writeSegment()
+      ,m_writeIndex( 0 )
+      ,m_synced( 0 )
+      ,m_unsynced( 0 )
+      ,m_retired()
+      ,m_syncing( false )
+      ,m_mutex()
+      ,m_condition()
+      ,m_syncCondition()
+   {
+      if ( m_recordsPerSegment == 0 || m_syncInterval == 0 )
+      {  throw std::invalid_argument( "Records per segment and sync interval have to be greater than 0" ); }
+
+      if ( mkdir( m_directory.c_str(), 0700 ) == -1 && errno != EEXIST )
+      {  throw std::system_error( errno, std::generic_category(), "Unable to create " + m_directory ); }
+
+      m_offsetFile = MappedFile( m_directory + "/offset", sizeof( Offset ) );
+      m_offset = reinterpret_cast< Offset* >( m_offsetFile.m_memory );
+      if ( m_offset->m_magic == 0 )
+      {
+         *m_offset = Offset{ Offset::Magic, sizeof( T ), m_recordsPerSegment, 0 };
+         m_offsetFile.Sync( 0, sizeof( Offset ) );
+      }
+      else if ( m_offset->m_magic != Offset::Magic || m_offset->m_recordSize != sizeof( T ) || m_offset->m_recordsPerSegment != m_recordsPerSegment )
+      {  throw std::invalid_argument( "Persistent queue has a different layout " + m_directory ); }
+
+      Recover();
+   }
+
+   ~PersistentQueue()
+   {
+      Cancel();
+      std::unique_lock< std::mutex > lock( m_mutex );
+      try { Flush( lock ); }
+      catch ( ... ) {} ///< Nothing to do about it here, the page cache gets written back eventually anyway
+   }
+
+   PersistentQueue( PersistentQueue const& ) = delete;
+   PersistentQueue& operator=( PersistentQueue const& ) = delete;
+
+   bool IsCanceled() const
+   {
+      std::unique_lock< std::mutex > lock( m_mutex );
+      return m_canceled;
+   }
+
+   size_t Size() const
+   {
+      std::unique_lock< std::mutex > lock( m_mutex );
+      return m_write - m_read;
+   }
+
+   void Cancel()
+   {
+      std::unique_lock< std::mutex > lock( m_mutex );
+      m_canceled = true;
+      m_condition.notify_all();
+   }
+
+   /** Writes pushed items and the position of the consumer back to disk */
+   void Sync()
+   {
+      std::unique_lock< std::mutex > lock( m_mutex );
+      Flush( lock );
+   }
+
+   void Push( T&& item )
+   {
+      std::unique_lock< std::mutex > lock( m_mutex );
+      if ( m_canceled )
+      {  throw std::logic_error( "Queue already canceled" ); }
+
+      Append( item );
+      m_condition.notify_one();
+      FlushWhenDue( lock );
+   }
+
+   /** Pushes all items within a single lock */
+   void PushBatch( std::vector< T >&& items )
+   {
+      std::unique_lock< std::mutex > lock( m_mutex );
+      if ( m_canceled )
+      {  throw std::logic_error( "Queue already canceled" ); }
+
+      for ( auto const& item : items )
+      {  Append( item ); }
+
+      if ( items.size() > 1 ) { m_condition.notify_all(); }
+      else                    { m_condition.notify_one(); }
+      FlushWhenDue( lock );
+   }
+
+   optional_value_type Pop()
+   {
+      std::unique_lock< std::mutex > lock( m_mutex );
+      if ( m_read == m_write )
+      {  return optional_value_type(); }
+      return optional_value_type( Take() );
+   }
+
+   /** Appends up to maximum items to batch within a single lock,
+    *  returns the number of items taken
+    * */
+   size_t PopBatch( std::vector< T >& batch, size_t maximum )
+   {
+      std::unique_lock< std::mutex > lock( m_mutex );
+      return TakeBatch( batch, maximum );
+   }
+
+   template < typename DurationType = std::chrono::seconds >
+   optional_value_type PopOrWait( DurationType duration = GetMax< DurationType >() )
+   {
+      std::unique_lock< std::mutex > lock( m_mutex );
+      if ( m_read == m_write )
+      {
+         m_condition.wait_for( lock, duration, [this]
+         { return m_canceled || m_read != m_write; } );
+
+         if ( m_read == m_write )
+         {  return optional_value_type(); }
+      }
+      return optional_value_type( Take() );
+   }
+
+   template < typename DurationType = std::chrono::seconds >
+   size_t PopBatchOrWait( std::vector< T >& batch, size_t maximum, DurationType duration = GetMax< DurationType >() )
+   {
+      std::unique_lock< std::mutex > lock( m_mutex );
+      if ( m_read == m_write )
+      {
+         m_condition.wait_for( lock, duration, [this]
+         { return m_canceled || m_read != m_write; } );
+      }
+      return TakeBatch( batch, maximum );
+   }
+
+private:
+   /** Content of the offset file */
+   struct Offset
+   {
+      static std::uint64_t const Magic = 0x5045525351554555; ///< "PERSQUEU"
+
+      std::uint64_t m_magic;
+      std::uint64_t m_recordSize;
+      std::uint64_t m_recordsPerSegment;
+      std::uint64_t m_consumed;     ///< Position of the next item to pop
+   };
+
+   /** Segments are zero initialized, a sequence of position + 1 marks a complete record */
+   struct Record
+   {
+      std::uint64_t m_sequence;
+      T m_item;
+   };
+   
+   /** Items of a segment not written back yet, the segment stays mapped until they are */
+   struct Dirty
+   {
+      std::shared_ptr< MappedFile > m_segment;
+      size_t m_begin;
+      size_t m_end;
+   };
+
+   std::string SegmentPath( size_t index ) const
+   {  return m_directory + "/segment-" + std::to_string( index ); }
+
+   MappedFile OpenSegment( size_t index ) const
+   {  return MappedFile( SegmentPath( index ), m_recordsPerSegment * sizeof( Record ) ); }
+   
+   std::shared_ptr< MappedFile > OpenSharedSegment( size_t index ) const
+   {  return std::make_shared< MappedFile >( OpenSegment( index ) ); }
+
+   Record& At( MappedFile& segment, size_t position ) const
+   {  return reinterpret_cast< Record* >( segment.m_memory )[ position % m_recordsPerSegment ]; }
+
+   /** Finds the end of the log by scanning the segments from the consumer position */
+   void Recover()
+   {
+      m_read = m_write = m_synced = m_unsynced = m_offset->m_consumed;
+      m_readIndex = m_writeIndex = m_read / m_recordsPerSegment;
+      if ( m_readIndex > 0 )
+      {  unlink( SegmentPath( m_readIndex - 1 ).c_str() ); } ///< In case the crash was right after consuming it
+
+      for ( auto index( m_readIndex ); access( SegmentPath( index ).c_str(), F_OK ) == 0; ++index )
+      {
+         auto const end( ( index + 1 ) * m_recordsPerSegment );
+         m_writeSegment = OpenSharedSegment( index );
+         m_writeIndex = index;
+         while ( m_write < end && At( *m_writeSegment, m_write ).m_sequence == m_write + 1 )
+         {  ++m_write; }
+         if ( m_write < end ) { break; }
+      }
+      m_synced = m_unsynced = m_write;
+   }
+
+   void Append( T const& item )
+   {
+      auto const index( m_write / m_recordsPerSegment );
+      if ( !m_writeSegment || index != m_writeIndex )
+      {
+         if ( m_writeSegment && m_unsynced < m_write ) ///< The rest of the previous segment is written back by the next flush
+         {  m_retired.emplace_back( Dirty{ m_writeSegment, m_unsynced, m_write } ); }
+         m_writeSegment = OpenSharedSegment( index );
+         m_writeIndex = index;
+         m_unsynced = m_write;
+      }
+
+      auto& record( At( *m_writeSegment, m_write ) );
+      record.m_item = item;
+      record.m_sequence = m_write + 1;
+      ++m_write;
+   }
+
+   T Take()
+   {
+      auto const index( m_read / m_recordsPerSegment );
+      if ( m_readSegment.m_memory == nullptr || index != m_readIndex )
+      {
+         m_readSegment = OpenSegment( index );
+         m_readIndex = index;
+      }
+
+      auto const r( At( m_readSegment, m_read ).m_item );
+      m_offset->m_consumed = ++m_read;
+      if ( m_read % m_recordsPerSegment == 0 )
+      {
+         /** The offset has to be on disk before the segment is gone, otherwise
+          *  a restart would look for the log in the missing segment
+          * */
+         m_offsetFile.Sync( 0, sizeof( Offset ) );
+         m_readSegment = MappedFile();
+         unlink( SegmentPath( index ).c_str() );
+      }
+      return r;
+   }
+
+   size_t TakeBatch( std::vector< T >& batch, size_t maximum )
+   {
+      size_t count( 0 );
+      for ( ; count < maximum && m_read != m_write; ++count )
+      {  batch.emplace_back( Take() ); }
+      return count;
+   }
+
+   void FlushWhenDue( std::unique_lock< std::mutex >& lock )
+   {
+      if ( !m_syncing && m_write - m_synced >= m_syncInterval )
+      {  Flush( lock ); }
+   }
+   
+   /** Takes the dirty ranges under the lock and writes them back without it, 
+    *  m_synced is published not until they are on disk. Waits for a flush 
+    *  in progress before, so everything pushed up to the call is written back.
+    * */
+   void Flush( std::unique_lock< std::mutex >& lock )
+   {
+      m_syncCondition.wait( lock, [ this ]{ return !m_syncing; } );
+      
+      auto dirty( std::move( m_retired ) );
+      m_retired.clear();
+      if ( m_writeSegment && m_unsynced < m_write )
+      {  dirty.emplace_back( Dirty{ m_writeSegment, m_unsynced, m_write } ); }
+      m_unsynced = m_write;
+      auto const synced( m_write );
+      m_syncing = true;
+      
+      lock.unlock();
+      std::exception_ptr error;
+      try
+      {
+         for ( auto const& d : dirty )
+         {
+            auto const begin( d.m_begin % m_recordsPerSegment );
+            auto const end( begin + d.m_end - d.m_begin );
+            d.m_segment->Sync( begin * sizeof( Record ), end * sizeof( Record ) );
+         }
+         m_offsetFile.Sync( 0, sizeof( Offset ) );
+      }
+      catch ( ... )
+      {  error = std::current_exception(); }
+      lock.lock();
+      
+      if ( error )
+      {  m_retired.insert( m_retired.begin(), dirty.begin(), dirty.end() ); } ///< Tried again by the next flush
+      else
+      {  m_synced = synced; }
+      m_syncing = false;
+      m_syncCondition.notify_all();
+      if ( error )
+      {  std::rethrow_exception( error ); }
+   }
+
+   std::string const m_directory;
+   size_t const m_recordsPerSegment;
+   size_t const m_syncInterval;
+   bool m_canceled;
+   MappedFile m_offsetFile;
+   Offset* m_offset;
+   size_t m_read;
+   MappedFile m_readSegment;
+   size_t m_readIndex;
+   size_t m_write;
+   std::shared_ptr< MappedFile > m_writeSegment; ///< Shared with a flush in progress
+   size_t m_writeIndex;
+   size_t m_synced;                    ///< Items up to here are written back already
+   size_t m_unsynced;                  ///< Items of the write segment from here on are not taken by a flush yet
+   std::vector< Dirty > m_retired;     ///< Rest of previous write segments, not taken by a flush yet
+   bool m_syncing;
+   mutable std::mutex m_mutex;
+   std::condition_variable m_condition;
+   std::condition_variable m_syncCondition;
+};
@@ -0,0 +1,355 @@
+#pragma once
+
+#include <vector>
+#include <future>
+#include <exception>
+#include <type_traits>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+
+struct PoolStatistics
+{
+   size_t m_chunks;        ///< Chunks taken from the heap to be split into blocks, never returned
+   size_t m_chunkBytes;
+   size_t m_refills;       ///< Batches of free blocks taken from the depot by a thread
+   size_t m_releases;      ///< Batches of free blocks given back to the depot by a thread
+   size_t m_oversized;     ///< Allocations too big for the size classes, passed to the heap
+};
+
+/** Recycling memory pool for small blocks like queue nodes and the
+ *  shared state of futures. Blocks are grouped into power of two size
+ *  classes. Each thread allocates from and frees into free lists of
+ *  its own, without any synchronization. When a list runs empty or
+ *  grows too long, a batch of blocks is moved from or to the global
+ *  depot, the only place taking a lock. Since producer and consumer
+ *  threads free what the other one allocated, the depot balances the
+ *  blocks between them and steady state processing does not touch the
+ *  heap at all.
+ * */
+struct Pool
+{
+   static size_t const ClassCount = 6;
+   static size_t const MinimumBlockSize = 16;
+   static size_t const MaximumBlockSize = MinimumBlockSize << ( ClassCount - 1 );
+   static size_t const BatchSize = 64;    ///< Number of blocks moved between thread and depot at once
+
+   static void* Allocate( size_t size )
+   {
+      if ( size > MaximumBlockSize )
+      {
+         ++GetDepot().m_oversized;
+         return ::operator new( size );
+      }
+
+      auto const c( ClassOf( size ) );
+      auto& cache( GetCache() );
+      if ( cache.m_exited ) ///< Thread local storage is gone already, so take a batch for this block only
+      {
+         auto list( GetDepot().Refill( c ) );
+         auto block( list.Pop() );
+         GetDepot().Release( c, list );
+         return block;
+      }
+
+      auto& list( cache.m_lists[ c ] );
+      if ( list.m_head == nullptr )
+      {  list = GetDepot().Refill( c ); }
+      return list.Pop();
+   }
+
+   static void Deallocate( void* block, size_t size )
+   {
+      if ( size > MaximumBlockSize )
+      {
+         ::operator delete( block );
+         return;
+      }
+
+      auto const c( ClassOf( size ) );
+      auto& cache( GetCache() );
+      if ( cache.m_exited )
+      {
+         FreeList list{ nullptr, 0 };
+         list.Push( block );
+         GetDepot().Release( c, list );
+         return;
+      }
+
+      auto& list( cache.m_lists[ c ] );
+      list.Push( block );
+      if ( list.m_count >= 2 * BatchSize ) ///< Keeps a batch for the thread itself to avoid ping-pong with the depot
+      {  GetDepot().Release( c, list.Split( BatchSize ) ); }
+   }
+
+   static PoolStatistics Statistics()
+   {
+      auto& depot( GetDepot() );
+      return PoolStatistics{ depot.m_chunks.load(), depot.m_chunkBytes.load(), depot.m_refills.load(), depot.m_releases.load(), depot.m_oversized.load() };
+   }
+
+private:
+   struct FreeList
+   {
+      void* m_head;
+      size_t m_count;
+
+      void Push( void* block )
+      {
+         *static_cast< void** >( block ) = m_head;
+         m_head = block;
+         ++m_count;
+      }
+
+      void* Pop()
+      {
+         auto block( m_head );
+         m_head = *static_cast< void** >( block );
+         --m_count;
+         return block;
+      }
+
+      /** Takes count blocks from the front */
+      FreeList Split( size_t count )
+      {
+         FreeList r{ m_head, count };
+         auto last( m_head );
+         for ( size_t i( 1 ); i < count; ++i )
+         {  last = *static_cast< void** >( last ); }
+         m_head = *static_cast< void** >( last );
+         *static_cast< void** >( last ) = nullptr;
+         m_count -= count;
+         return r;
+      }
+   };
+
+   struct Depot
+   {
+      Depot() :
+          m_mutex()
+         ,m_batches()
+         ,m_chunks( 0 )
+         ,m_chunkBytes( 0 )
+         ,m_refills( 0 )
+         ,m_releases( 0 )
+         ,m_oversized( 0 )
+      {}
+
+      FreeList Refill( size_t c )
+      {
+         ++m_refills;
+         {
+            std::unique_lock< std::mutex > lock( m_mutex );
+            auto& batches( m_batches[ c ] );
+            if ( !batches.empty() )
+            {
+               auto r( batches.back() );
+               batches.pop_back();
+               return r;
+            }
+         }
+
+         /** A new chunk is split outside of the lock */
+         auto const size( BlockSize( c ) );
+         auto chunk( static_cast< char* >( ::operator new( size * BatchSize ) ) );
+         ++m_chunks;
+         m_chunkBytes += size * BatchSize;
+         FreeList r{ nullptr, 0 };
+         for ( size_t i( BatchSize ); i > 0; --i )
+         {  r.Push( chunk + ( i - 1 ) * size ); }
+         return r;
+      }
+
+      void Release( size_t c, FreeList list )
+      {
+         if ( list.m_count == 0 ) { return; }
+
+         ++m_releases;
+         std::unique_lock< std::mutex > lock( m_mutex );
+         m_batches[ c ].emplace_back( list );
+      }
+
+      std::mutex m_mutex;
+      std::vector< FreeList > m_batches[ ClassCount ];
+      std::atomic< size_t > m_chunks;
+      std::atomic< size_t > m_chunkBytes;
+      std::atomic< size_t > m_refills;
+      std::atomic< size_t > m_releases;
+      std::atomic< size_t > m_oversized;
+   };
+
+   /** Trivially destructible, so it is still accessible when
+    *  the guard has flushed it at the end of the thread.
+    * */
+   struct ThreadCache
+   {
+      FreeList m_lists[ ClassCount ];
+      bool m_exited;
+   };
+
+   struct ThreadCacheGuard
+   {
+      ~ThreadCacheGuard()
+      {
+         auto& cache( GetCache() );
+         for ( size_t c( 0 ); c < ClassCount; ++c )
+         {
+            GetDepot().Release( c, cache.m_lists[ c ] );
+            cache.m_lists[ c ] = FreeList{ nullptr, 0 };
+         }
+         cache.m_exited = true;
+      }
+   };
+
+   static size_t BlockSize( size_t c )
+   {  return MinimumBlockSize << c; }
+
+   static size_t ClassOf( size_t size )
+   {
+      size_t c( 0 );
+      while ( BlockSize( c ) < size ) { ++c; }
+      return c;
+   }
+
+   /** Never destroyed, blocks may still be freed by static objects at exit */
+   static Depot& GetDepot()
+   {
+      static Depot* depot( new Depot() );
+      return *depot;
+   }
+
+   static ThreadCache& GetCache()
+   {
+      static thread_local ThreadCache cache;
+      static thread_local ThreadCacheGuard guard;
+      (void)guard;
+      return cache;
+   }
+};
+
+/** Allocator for containers and the shared state of futures using the Pool */
+template < typename T >
+struct PoolAllocator
+{
+   typedef T value_type;
+
+   PoolAllocator() noexcept {}
+
+   template < typename U >
+   PoolAllocator( PoolAllocator< U > const& ) noexcept {}
+
+   T* allocate( size_t n )
+   {
+      if ( alignof( T ) > alignof( std::max_align_t ) ) ///< Blocks are aligned like memory from operator new only
+      {  return static_cast< T* >( ::operator new( n * sizeof( T ) ) ); }
+      return static_cast< T* >( Pool::Allocate( n * sizeof( T ) ) );
+   }
+
+   void deallocate( T* p, size_t n ) noexcept
+   {
+      if ( alignof( T ) > alignof( std::max_align_t ) )
+      {  ::operator delete( p ); }
+      else
+      {  Pool::Deallocate( p, n * sizeof( T ) ); }
+   }
+};
+
+template < typename T, typename U >
+bool operator==( PoolAllocator< T > const&, PoolAllocator< U > const& ) { return true; }
+
+template < typename T, typename U >
+bool operator!=( PoolAllocator< T > const&, PoolAllocator< U > const& ) { return false; }
+
+/** Like std::packaged_task< ResultT() >, but the shared state and the 
+ *  function are both taken from the Pool. The allocator constructor of 
+ *  std::packaged_task got removed by C++17, the one of std::promise not.
+ * */
+template < typename ResultT >
+struct PooledTask
+{
+   PooledTask() : m_promise(), m_function() {}
+   
+   template < typename FunctionT >
+   explicit PooledTask( FunctionT&& function ) :
+       m_promise( std::allocator_arg, PoolAllocator< PooledTask >() )
+      ,m_function( Create( std::forward< FunctionT >( function ) ) )
+   {}
+   
+   PooledTask( PooledTask&& ) = default;
+   PooledTask& operator=( PooledTask&& ) = default;
+   
+   std::future< ResultT > get_future()
+   {  return m_promise.get_future(); }
+   
+   void operator()()
+   {
+      try 
+      {  Run( std::is_void< ResultT >() ); }
+      catch ( ... ) 
+      {  m_promise.set_exception( std::current_exception() ); }
+   }
+   
+private:
+   struct Callable
+   {
+      virtual ~Callable() {}
+      virtual ResultT Invoke() = 0;
+      virtual void Destroy() = 0; ///< Destructs and gives the memory back to the Pool
+   };
+   
+   template < typename FunctionT >
+   struct CallableOf : Callable
+   {
+      explicit CallableOf( FunctionT&& function ) : m_function( std::move( function ) ) {}
+      
+      ResultT Invoke() override 
+      {  return Invoke( std::is_void< ResultT >() ); }
+      
+      void Invoke( std::true_type )     { m_function(); } ///< The result of the function is ignored like by std::packaged_task< void() >
+      ResultT Invoke( std::false_type ) { return m_function(); }
+      
+      void Destroy() override
+      {
+         this->~CallableOf();
+         PoolAllocator< CallableOf >().deallocate( this, 1 );
+      }
+      
+      FunctionT m_function;
+   };
+   
+   struct Deleter
+   {
+      void operator()( Callable* callable ) const
+      {  callable->Destroy(); }
+   };
+   
+   template < typename FunctionT >
+   static std::unique_ptr< Callable, Deleter > Create( FunctionT&& function )
+   {
+      typedef CallableOf< std::decay_t< FunctionT > > callable_type;
+      PoolAllocator< callable_type > allocator;
+      auto memory( allocator.allocate( 1 ) );
+      try 
+      {  return std::unique_ptr< Callable, Deleter >( new ( memory ) callable_type( std::decay_t< FunctionT >( std::forward< FunctionT >( function ) ) ) ); }
+      catch ( ... )
+      {
+         allocator.deallocate( memory, 1 );
+         throw;
+      }
+   }
+   
+   void Run( std::false_type )
+   {  m_promise.set_value( m_function->Invoke() ); }
+   
+   void Run( std::true_type )
+   {
+      m_function->Invoke();
+      m_promise.set_value();
+   }
+   
+   std::promise< ResultT > m_promise;
+   std::unique_ptr< Callable, Deleter > m_function;
+};
@@ -1,16 +1,26 @@
 #pragma once
 
+#include "PoolAllocator.h"
+
 #include <boost/optional/optional.hpp>
 
 #include <vector>
 #include <future>
 #include <algorithm>
 #include <atomic>
+#include <memory>
 #include <queue>
+#include <deque>
 #include <functional>
 #include <mutex>
 #include <stdexcept>
 #include <condition_variable>
+#include <thread>
+#include <cstdint>
+
+#ifndef PROCESSOR_CACHE_LINE_SIZE
+#define PROCESSOR_CACHE_LINE_SIZE 64
+#endif
 
 namespace
 {
@@ -22,6 +32,15 @@ namespace
       return std::chrono::duration_cast< DurationType >( std::chrono::hours( 8736 ) /* one year */ );
    }
    
+   size_t const HandoffBatchSize( 64 ); ///< Maximum number of results moved at once between stages
+   
+   /** Fields written by different threads are kept at least this far apart, 
+    *  it is done by padding since over-aligned types cannot be allocated by 
+    *  new before C++17. PROCESSOR_CACHE_LINE_SIZE=1 builds without padding 
+    *  to compare, arrays cannot have a size of 0.
+    * */
+   size_t const CacheLineSize( PROCESSOR_CACHE_LINE_SIZE );
+   
    template < typename FunctionT, typename... ArgumentT >
    auto CreateWorker( size_t workerCount, FunctionT&& function, ArgumentT&&... arguments )
    {
@@ -32,23 +51,139 @@ namespace
    }
    
    template < typename WorkerT >
-   void JoinWorker( WorkerT&& worker )
+   void JoinWorker( WorkerT worker ) ///< Taken by value, so the moved from member is empty afterwards
    {
       std::for_each( worker.begin(), worker.end(), []( std::future< void >& future )
       {  future.get(); } );
    }
+   
+   /** True when all workers are finished within the duration, they are not joined here */
+   template < typename WorkerT, typename DurationType >
+   bool WaitForWorker( WorkerT const& worker, DurationType duration )
+   {
+      auto const deadline( std::chrono::steady_clock::now() + duration );
+      return std::all_of( worker.begin(), worker.end(), [ &deadline ]( std::future< void > const& future )
+      {  return !future.valid() || future.wait_until( deadline ) == std::future_status::ready; } );
+   }
+}
+
+/** Stored into the futures of tasks that got discarded
+ *  because their processor was canceled with CancelMode::Discard
+ * */
+struct OperationCanceled : std::runtime_error
+{
+   OperationCanceled() : std::runtime_error( "Operation canceled" ) {}
+};
+
+enum class CancelMode
+{
+   Drain,   ///< Already enqueued tasks are processed before the workers leave
+   Discard  ///< Already enqueued tasks are skipped and running tasks are signaled via CancellationToken
+};
+
+/** Cheap to copy view on the cancellation state of a processor,
+ *  long running functions should check it from time to time.
+ *  A token is valid as long as the processor it belongs to.
+ * */
+struct CancellationToken
+{
+   explicit CancellationToken( std::atomic< bool > const& canceled ) : m_canceled( &canceled ) {}
+   
+   bool IsCanceled() const
+   {  return m_canceled->load(); }
+   
+   void ThrowIfCanceled() const
+   {
+      if ( IsCanceled() )
+      {  throw OperationCanceled(); }
+   }
+   
+private:
+   std::atomic< bool > const* m_canceled;
+};
+
+struct CancellationSource
+{
+   CancellationSource() : m_canceled( false ), m_discarded( 0 ) {}
+   
+   bool IsCanceled() const
+   {  return m_canceled.load(); }
+   
+   void Cancel()
+   {  m_canceled.store( true ); }
+   
+   CancellationToken GetToken() const
+   {  return CancellationToken( m_canceled ); }
+   
+   /** Number of tasks skipped because they did not start before the cancellation */
+   size_t DiscardedCount() const
+   {  return m_discarded.load(); }
+   
+   void CountDiscarded()
+   {  ++m_discarded; }
+   
+private:
+   std::atomic< bool > m_canceled;
+   std::atomic< size_t > m_discarded;
+};
+
+namespace
+{
+   template < typename FunctionT, typename = void >
+   struct AcceptsCancellationToken : std::false_type {};
+   
+   template < typename FunctionT >
+   struct AcceptsCancellationToken< FunctionT, decltype( void( std::declval< FunctionT& >()( std::declval< CancellationToken const& >() ) ) ) > : std::true_type {};
+   
+   /** Wraps a task, so it gets skipped when the token is canceled before 
+    *  the task starts and gets the token passed when the function accepts it.
+    * */
+   template < typename FunctionT >
+   struct CancelableTask
+   {
+      CancelableTask( FunctionT&& function, CancellationSource& source ) : m_function( std::move( function ) ), m_source( source ) {}
+      
+      auto operator()()
+      {
+         if ( m_source.IsCanceled() )
+         {
+            m_source.CountDiscarded();
+            throw OperationCanceled();
+         }
+         return Invoke( AcceptsCancellationToken< FunctionT >() );
+      }
+      
+   private:
+      auto Invoke( std::true_type )  { return m_function( m_source.GetToken() ); }
+      auto Invoke( std::false_type ) { return m_function(); }
+   
+      FunctionT m_function;
+      CancellationSource& m_source;
+   };
+   
+   template < typename ResultT, typename FunctionT >
+   PooledTask< ResultT > MakeTask( FunctionT&& function )
+   {  return PooledTask< ResultT >( std::forward< FunctionT >( function ) ); }
+   
+   template < typename FunctionT >
+   auto MakeCancelable( FunctionT&& function, CancellationSource& source )
+   {  return CancelableTask< std::decay_t< FunctionT > >( std::decay_t< FunctionT >( std::forward< FunctionT >( function ) ), source ); }
 }
  
-template < typename T >
+template < typename T, typename AllocatorT = std::allocator< T > >
 struct Queue
 {
    typedef T value_type;
    typedef boost::optional< value_type > optional_value_type;
    
-   Queue() : 
+   /** With shared, the queue takes the mutex of another queue instead of its
+    *  own, so both can be pushed within a single critical section, see PushLocked()
+    * */
+   explicit Queue( std::mutex* shared = nullptr ) : 
       m_canceled( false )
      ,m_queue()
-     ,m_mutex()
+     ,m_ownMutex()
+     ,m_mutex( shared ? *shared : m_ownMutex )
      ,m_condition() 
    {}
    
@@ -63,6 +198,12 @@ struct Queue
       return m_canceled;
    }
    
+   size_t Size() const
+   {
+      std::unique_lock< std::mutex > lock( m_mutex );
+      return m_queue.size();
+   }
+   
    void Cancel()
    {
       std::unique_lock< std::mutex > lock( m_mutex );
@@ -71,15 +212,54 @@ struct Queue
    }
    
    void Push( T&& item )
+   {  Push( std::move( item ), []{} ); }
+   
+   /** Calls whileLocked() within the same critical section before the item 
+    *  becomes visible, so whatever it does is ordered like the items of this
+    *  queue without another lock. When it throws, the item is not pushed.
+    * */
+   template < typename FunctionT >
+   void Push( T&& item, FunctionT&& whileLocked )
    {
       std::unique_lock< std::mutex > lock( m_mutex );
-      if ( m_canceled )
-      {  throw std::logic_error( "Queue already canceled" ); }
-      
+      ThrowIfCanceled();
+      whileLocked();
+      PushLocked( std::move( item ) );
+   }
+   
+   /** The caller has to hold Mutex() already, like whileLocked() of 
+    *  another queue sharing it
+    * */
+   void PushLocked( T&& item )
+   {
+      ThrowIfCanceled();
       m_queue.emplace( std::move( item ) );
       m_condition.notify_one();
    }
    
+   /** Pushes all items within a single lock */
+   void PushBatch( std::vector< T >&& items )
+   {  PushBatch( std::move( items ), []{} ); }
+   
+   template < typename FunctionT >
+   void PushBatch( std::vector< T >&& items, FunctionT&& whileLocked )
+   {
+      std::unique_lock< std::mutex > lock( m_mutex );
+      ThrowIfCanceled();
+      whileLocked();
+      PushBatchLocked( std::move( items ) );
+   }
+   
+   void PushBatchLocked( std::vector< T >&& items )
+   {
+      ThrowIfCanceled();
+      for ( auto& item : items )
+      {  m_queue.emplace( std::move( item ) ); }
+      
+      if ( items.size() > 1 ) { m_condition.notify_all(); }
+      else                    { m_condition.notify_one(); }
+   }
+   
    optional_value_type Pop()
    {
       std::unique_lock< std::mutex > lock( m_mutex );
@@ -90,6 +270,15 @@ struct Queue
       m_queue.pop();
       return optional_value_type(std::move(r));
    }
+   
+   /** Appends up to maximum items to batch within a single lock,
+    *  returns the number of items taken
+    * */
+   size_t PopBatch( std::vector< T >& batch, size_t maximum )
+   {
+      std::unique_lock< std::mutex > lock( m_mutex );
+      return TakeBatch( batch, maximum );
+   }
             
    template < typename DurationType = std::chrono::seconds >
    optional_value_type PopOrWait( DurationType duration = GetMax< DurationType >() )
@@ -109,11 +298,438 @@ struct Queue
       return optional_value_type(std::move(r));
    }
    
+   template < typename DurationType = std::chrono::seconds >
+   size_t PopBatchOrWait( std::vector< T >& batch, size_t maximum, DurationType duration = GetMax< DurationType >() )
+   {
+      std::unique_lock< std::mutex > lock( m_mutex );
+      if ( m_queue.empty() )
+      {
+         m_condition.wait_for( lock, duration, [this]
+         { return m_canceled || !m_queue.empty(); } );
+      }
+      return TakeBatch( batch, maximum );
+   }
+   
+   std::mutex& Mutex() const
+   {  return m_mutex; }
+   
 private:
+   void ThrowIfCanceled() const
+   {
+      if ( m_canceled )
+      {  throw std::logic_error( "Queue already canceled" ); }
+   }
+   
+   size_t TakeBatch( std::vector< T >& batch, size_t maximum )
+   {
+      auto const count( std::min( maximum, m_queue.size() ) );
+      for ( size_t i( 0 ); i < count; ++i )
+      {
+         batch.emplace_back( std::move( m_queue.front() ) );
+         m_queue.pop();
+      }
+      return count;
+   }
+   
    bool m_canceled;
-   std::queue< value_type > m_queue;
-   mutable std::mutex m_mutex;
+   std::queue< value_type, std::deque< value_type, AllocatorT > > m_queue;
+   std::mutex m_ownMutex;
+   std::mutex& m_mutex; ///< Either m_ownMutex or the one of another queue
    std::condition_variable m_condition;
+   char m_padding[ CacheLineSize ]; ///< Keeps the fields of the owner following the queue off its lines
+};
+   
+/** Blocking, notification and cancellation shared by the 
+ *  single consumer queues below. The consumer announces it is 
+ *  going to sleep by m_waiting, so producers take the mutex only
+ *  when somebody has to be woken up. Producers in flight are
+ *  counted, so Cancel() returns not until all of them are done 
+ *  and a consumer draining a canceled queue cannot miss an item.
+ *  The canceled flag, the producers in flight and the number of 
+ *  pushed items share a single word, so a push costs two atomic
+ *  read-modify-writes of it only.
+ * */
+struct LinkSignal
+{
+   LinkSignal() :
+       m_state( 0 )
+      ,m_waiting( false )
+      ,m_mutex()
+      ,m_condition()
+   {}
+   
+   bool IsCanceled() const
+   {  return ( m_state.load() & Canceled ) != 0; }
+   
+   void Cancel()
+   {
+      m_state.fetch_or( Canceled );
+      while ( ( m_state.load() & Producers ) != 0 )
+      {  std::this_thread::yield(); }
+      
+      std::unique_lock< std::mutex > lock( m_mutex );
+      m_condition.notify_all();
+   }
+   
+   /** Has to be called before items get linked, throws when canceled */
+   void EnterPush()
+   {
+      if ( ( m_state.fetch_add( Producer ) & Canceled ) != 0 )
+      {
+         m_state.fetch_sub( Producer );
+         throw std::logic_error( "Queue already canceled" );
+      }
+   }
+   
+   /** Has to be called after count items got linked */
+   void LeavePush( size_t count )
+   {
+      m_state.fetch_add( count * Pushed - Producer );
+      if ( m_waiting.load() )
+      {
+         std::unique_lock< std::mutex > lock( m_mutex );
+         m_condition.notify_one();
+      }
+   }
+   
+   /** Number of items pushed ever, modulo 2^32 */
+   std::uint32_t PushedCount() const
+   {  return static_cast< std::uint32_t >( m_state.load() / Pushed ); }
+   
+   template < typename DurationType, typename PredicateT >
+   void Wait( DurationType duration, PredicateT available )
+   {
+      std::unique_lock< std::mutex > lock( m_mutex );
+      m_waiting.store( true );
+      m_condition.wait_for( lock, duration, [ this, &available ]
+      {  return IsCanceled() || available(); } );
+      m_waiting.store( false );
+   }
+   
+private:
+   static std::uint64_t const Canceled = 1;                              ///< Bit 0
+   static std::uint64_t const Producer = 2;                              ///< Bits 1 to 31 count producers in flight
+   static std::uint64_t const Pushed = std::uint64_t( 1 ) << 32;         ///< Bits 32 to 63 count pushed items
+   static std::uint64_t const Producers = Pushed - Producer;
+   
+   std::atomic< std::uint64_t > m_state; ///< Producer side
+   char m_padding[ CacheLineSize ];
+   std::atomic< bool > m_waiting;        ///< Consumer side from here on
+   std::mutex m_mutex;
+   std::condition_variable m_condition;
+};
+
+/** Interface of Queue on top of TryPop() and Link() of the
+ *  derived queue, which have to support a single consumer only.
+ * */
+template < typename DerivedT, typename T >
+struct SingleConsumerQueue
+{
+   typedef T value_type;
+   typedef boost::optional< value_type > optional_value_type;
+   
+   SingleConsumerQueue() : m_signal(), m_popped( 0 ) {}
+   
+   bool IsCanceled() const
+   {  return m_signal.IsCanceled(); }
+   
+   size_t Size() const
+   {  return static_cast< std::uint32_t >( m_signal.PushedCount() - m_popped.load() ); }
+   
+   void Cancel()
+   {  m_signal.Cancel(); }
+   
+   void Push( T&& item )
+   {
+      m_signal.EnterPush();
+      Derived().Link( std::move( item ) );
+      m_signal.LeavePush( 1 );
+   }
+   
+   void PushBatch( std::vector< T >&& items )
+   {
+      m_signal.EnterPush();
+      for ( auto& item : items )
+      {  Derived().Link( std::move( item ) ); }
+      m_signal.LeavePush( items.size() );
+   }
+   
+   optional_value_type Pop()
+   {
+      auto item( Derived().TryPop() );
+      if ( item ) ///< There is a single consumer only, so there is no need for a read-modify-write
+      {  m_popped.store( m_popped.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed ); }
+      return item;
+   }
+   
+   size_t PopBatch( std::vector< T >& batch, size_t maximum )
+   {
+      size_t count( 0 );
+      for ( ; count < maximum; ++count )
+      {
+         auto item( Pop() );
+         if ( !item ) { break; }
+         batch.emplace_back( std::move( item.value() ) );
+      }
+      return count;
+   }
+   
+   template < typename DurationType = std::chrono::seconds >
+   optional_value_type PopOrWait( DurationType duration = GetMax< DurationType >() )
+   {
+      auto item( Pop() );
+      if ( item ) { return item; }
+      
+      m_signal.Wait( duration, [ this ]{ return Derived().IsAvailable(); } );
+      return Pop();
+   }
+   
+   template < typename DurationType = std::chrono::seconds >
+   size_t PopBatchOrWait( std::vector< T >& batch, size_t maximum, DurationType duration = GetMax< DurationType >() )
+   {
+      if ( !Derived().IsAvailable() )
+      {  m_signal.Wait( duration, [ this ]{ return Derived().IsAvailable(); } ); }
+      return PopBatch( batch, maximum );
+   }
+   
+private:
+   DerivedT& Derived() 
+   {  return static_cast< DerivedT& >( *this ); }
+   
+   LinkSignal m_signal;
+   std::atomic< std::uint32_t > m_popped;
+};
+
+/** Node of the single consumer queues, taken from the Pool */
+template < typename T >
+struct LinkNode
+{
+   LinkNode() : m_next( nullptr ), m_value() {}
+   
+   static LinkNode* Create()
+   {  return new ( PoolAllocator< LinkNode >().allocate( 1 ) ) LinkNode(); }
+   
+   static void Destroy( LinkNode* node )
+   {
+      node->~LinkNode();
+      PoolAllocator< LinkNode >().deallocate( node, 1 );
+   }
+   
+   std::atomic< LinkNode* > m_next;
+   boost::optional< T > m_value;
+};
+
+/** Unbounded single producer single consumer queue after D. Vyukov,
+ *  push and pop are wait-free except allocation of new nodes. Nodes
+ *  already passed by the consumer are reused by the producer. Pushes
+ *  from several threads are fine when they are serialized, like
+ *  the pushes to the output of BufferingTaskProcessor.
+ * */
+template < typename T >
+struct SpscQueue : SingleConsumerQueue< SpscQueue< T >, T >
+{
+   SpscQueue() : m_tail(), m_head(), m_first(), m_tailCopy()
+   {
+      auto node( Node::Create() );
+      m_tail.store( node );
+      m_head = m_first = m_tailCopy = node;
+   }
+   
+   ~SpscQueue()
+   {
+      this->Cancel();
+      while ( m_first )
+      {
+         auto next( m_first->m_next.load() );
+         Node::Destroy( m_first );
+         m_first = next;
+      }
+   }
+   
+   SpscQueue( SpscQueue const& ) = delete;
+   SpscQueue& operator=( SpscQueue const& ) = delete;
+   
+private:
+   friend struct SingleConsumerQueue< SpscQueue< T >, T >;
+   
+   typedef LinkNode< T > Node;
+   
+   void Link( T&& item )
+   {
+      auto node( Allocate() );
+      node->m_next.store( nullptr, std::memory_order_relaxed );
+      node->m_value.emplace( std::move( item ) );
+      m_head->m_next.store( node, std::memory_order_release ); ///< The read-modify-write in LeavePush orders it before the waiting flag is read
+      m_head = node;
+   }
+   
+   bool IsAvailable() const
+   {  return m_tail.load()->m_next.load() != nullptr; }
+   
+   boost::optional< T > TryPop()
+   {
+      auto tail( m_tail.load( std::memory_order_relaxed ) );
+      auto next( tail->m_next.load( std::memory_order_acquire ) );
+      if ( !next )
+      {  return boost::none; }
+      
+      auto r( std::move( next->m_value.get() ) );
+      next->m_value = boost::none; ///< The next node becomes the dummy
+      m_tail.store( next, std::memory_order_release );
+      return boost::optional< T >( std::move( r ) );
+   }
+   
+   Node* Allocate()
+   {
+      if ( m_first == m_tailCopy )
+      {  m_tailCopy = m_tail.load( std::memory_order_acquire ); }
+      if ( m_first != m_tailCopy )
+      {
+         auto node( m_first );
+         m_first = m_first->m_next.load( std::memory_order_relaxed );
+         return node;
+      }
+      return Node::Create();
+   }
+   
+   std::atomic< Node* > m_tail; ///< Consumer side, the dummy in front of the oldest item
+   char m_padding0[ CacheLineSize ];
+   Node* m_head;                ///< Producer side, the newest item
+   Node* m_first;               ///< Producer side, the oldest node to reuse
+   Node* m_tailCopy;            ///< Producer side, the consumer position when seen last
+   char m_padding1[ CacheLineSize ];
+};
+
+/** Unbounded multiple producer single consumer queue after D. Vyukov,
+ *  a push is a single exchange plus a store. The consumer may see 
+ *  an empty queue while a producer is between both, the signal wakes
+ *  it up when the producer is done.
+ * */
+template < typename T >
+struct MpscQueue : SingleConsumerQueue< MpscQueue< T >, T >
+{
+   MpscQueue() : m_tail( Node::Create() ), m_head( m_tail ) {}
+   
+   ~MpscQueue()
+   {
+      this->Cancel();
+      while ( m_tail )
+      {
+         auto next( m_tail->m_next.load() );
+         Node::Destroy( m_tail );
+         m_tail = next;
+      }
+   }
+   
+   MpscQueue( MpscQueue const& ) = delete;
+   MpscQueue& operator=( MpscQueue const& ) = delete;
+   
+private:
+   friend struct SingleConsumerQueue< MpscQueue< T >, T >;
+   
+   typedef LinkNode< T > Node;
+   
+   void Link( T&& item )
+   {
+      auto node( Node::Create() );
+      node->m_value.emplace( std::move( item ) );
+      auto previous( m_head.exchange( node, std::memory_order_acq_rel ) );
+      previous->m_next.store( node, std::memory_order_release ); ///< The read-modify-write in LeavePush orders it before the waiting flag is read
+   }
+   
+   bool IsAvailable() const
+   {  return m_tail->m_next.load() != nullptr; }
+   
+   boost::optional< T > TryPop()
+   {
+      auto next( m_tail->m_next.load( std::memory_order_acquire ) );
+      if ( !next )
+      {  return boost::none; }
+      
+      auto r( std::move( next->m_value.get() ) );
+      next->m_value = boost::none; ///< The next node becomes the dummy
+      Node::Destroy( m_tail );
+      m_tail = next;
+      return boost::optional< T >( std::move( r ) );
+   }
+   
+   Node* m_tail;                ///< Consumer side, the dummy in front of the oldest item
+   char m_padding0[ CacheLineSize ];
+   std::atomic< Node* > m_head; ///< Producer side, the newest item
+   char m_padding1[ CacheLineSize ];
+};
+
+/** Tags describing who is accessing the output of a stage */
+struct MpmcLink {}; ///< Any number of threads push and pop, the default
+struct MpscLink {}; ///< Any number of threads push, a single thread like a successor stage pops
+struct SpscLink {}; ///< Serialized pushes only and a single thread pops
+
+template < typename LinkT, typename T >
+struct LinkQueue;
+
+template < typename T >
+struct LinkQueue< MpmcLink, T > { typedef Queue< T, PoolAllocator< T > > type; };
+
+template < typename T >
+struct LinkQueue< MpscLink, T > { typedef MpscQueue< T > type; };
+
+template < typename T >
+struct LinkQueue< SpscLink, T > { typedef SpscQueue< T > type; };
+
+/** Whether several threads may push to or pop from a queue, checked 
+ *  by the stages accessing a link from several threads at once
+ * */
+template < typename QueueT >
+struct QueueConcurrency
+{
+   static bool const MultipleProducers = true;
+   static bool const MultipleConsumers = true;
+};
+
+template < typename T >
+struct QueueConcurrency< MpscQueue< T > >
+{
+   static bool const MultipleProducers = true;
+   static bool const MultipleConsumers = false;
+};
+
+template < typename T >
+struct QueueConcurrency< SpscQueue< T > >
+{
+   static bool const MultipleProducers = false;
+   static bool const MultipleConsumers = false;
+};
+
+/** The input queue of a stage shares the mutex of its output, when the output 
+ *  is a Queue, so pushing a task and its future is a single critical section. 
+ *  The other queues push without a mutex anyway.
+ * */
+template < typename QueueT >
+struct MutexSharing
+{
+   static std::mutex* Of( QueueT& )
+   {  return nullptr; }
+   
+   template < typename T >
+   static void Push( QueueT& queue, T&& item )
+   {  queue.Push( std::forward< T >( item ) ); }
+   
+   template < typename T >
+   static void PushBatch( QueueT& queue, std::vector< T >&& items )
+   {  queue.PushBatch( std::move( items ) ); }
+};
+
+template < typename T, typename AllocatorT >
+struct MutexSharing< Queue< T, AllocatorT > >
+{
+   static std::mutex* Of( Queue< T, AllocatorT >& queue )
+   {  return &queue.Mutex(); }
+   
+   static void Push( Queue< T, AllocatorT >& queue, T&& item )
+   {  queue.PushLocked( std::move( item ) ); }
+   
+   static void PushBatch( Queue< T, AllocatorT >& queue, std::vector< T >&& items )
+   {  queue.PushBatchLocked( std::move( items ) ); }
 };
    
 /** This is considered as an internal helper class
@@ -121,11 +737,11 @@ private:
  *  All methods should NOT use the mutex member internally,
  *  it has to be used by clients for in a wider scope.
  * */
-template < typename T >
+template < typename T, typename QueueT = Queue< T, PoolAllocator< T > > >
 struct ProcessorBase
 {
    typedef T value_type;
-   typedef Queue< T > queue_type;
+   typedef QueueT queue_type;
    
    ProcessorBase() : m_output(), m_mutex() {}
                              
@@ -139,24 +755,86 @@ struct ProcessorBase
    auto Lock() const
    {  return std::move( std::unique_lock< std::mutex >( m_mutex ) ); }
    
-   queue_type m_output;
-   mutable std::mutex m_mutex;
+   queue_type m_output;         ///< All queues end with a padding
+   mutable std::mutex m_mutex;  ///< Taken by clients around several calls
 };
 
 template < typename QueueT >
 struct TaskWorker
 {
-   TaskWorker( QueueT& queue ) : m_queue( queue ) {}
+   /** With a batch size above 1, the worker takes several tasks at once
+    *  into a local buffer. This saves locking of the shared queue for 
+    *  short tasks, but other workers may idle meanwhile.
+    * */
+   TaskWorker( QueueT& queue, size_t batchSize = 1 ) : m_queue( queue ), m_batchSize( std::max< size_t >( batchSize, 1 ) ) {}
    
    void operator()()
    {
+      std::vector< typename QueueT::value_type > batch;
+      batch.reserve( m_batchSize );
       while ( !m_queue.IsCanceled() )
       {
          /** The timeout here avoids a deadlock when between 
           *  IsCanceled and Pop the internal queue state changes
           * */
-         auto item( m_queue.PopOrWait( std::chrono::seconds( 1 ) ) );
-         if ( item ) { item.value()(); }
+         if ( m_queue.PopBatchOrWait( batch, m_batchSize, std::chrono::seconds( 1 ) ) ) 
+         {  Run( batch ); }
+      }
+      while ( m_queue.PopBatch( batch, m_batchSize ) ) ///< Canceled but we finish all enqueued work before we leave
+      {  Run( batch ); }
+   }
+   
+private:
+   template < typename BatchT >
+   void Run( BatchT& batch )
+   {
+      for ( auto& task : batch ) { task(); }
+      batch.clear();
+   }
+   
+   QueueT& m_queue;
+   size_t m_batchSize;
+};
+
+/** Limits and thresholds for a varying number of workers */
+struct ElasticWorkerPolicy
+{
+   size_t m_minimum;
+   size_t m_maximum;
+   size_t m_queueDepthThreshold;                            ///< A worker is added when more tasks are waiting on push
+   std::chrono::steady_clock::duration m_waitTimeThreshold; ///< A worker is added when a task waited longer to be started
+   std::chrono::steady_clock::duration m_idleTimeout;       ///< A worker is retired when it got no task for longer
+};
+
+struct WorkerScalingStatistics
+{
+   size_t m_current;
+   size_t m_peak;
+   size_t m_started;
+   size_t m_retired;
+};
+
+template < typename QueueT, typename PoolT >
+struct ElasticTaskWorker
+{
+   ElasticTaskWorker( QueueT& queue, PoolT& pool ) : m_queue( queue ), m_pool( pool ) {}
+   
+   void operator()()
+   {
+      auto lastTask( std::chrono::steady_clock::now() );
+      while ( !m_queue.IsCanceled() )
+      {
+         /** The timeout here avoids a deadlock when between 
+          *  IsCanceled and Pop the internal queue state changes
+          * */
+         auto item( m_queue.PopOrWait( std::min< std::chrono::steady_clock::duration >( std::chrono::seconds( 1 ), m_pool.IdleTimeout() ) ) );
+         if ( item ) 
+         { 
+            item.value()(); 
+            lastTask = std::chrono::steady_clock::now();
+         }
+         else if ( std::chrono::steady_clock::now() - lastTask >= m_pool.IdleTimeout() && m_pool.TryRetire() )
+         {  return; }
       }
       while ( 1 ) ///< Canceled but we finish all enqueued work before we leave
       {
@@ -168,17 +846,158 @@ struct TaskWorker
    
 private:
    QueueT& m_queue;
+   PoolT& m_pool;
+};
+
+/** Workers for a queue, started and retired according to the policy */
+template < typename QueueT >
+struct ElasticWorkerPool
+{
+   ElasticWorkerPool( QueueT& queue, ElasticWorkerPolicy policy ) :
+       m_queue( queue )
+      ,m_policy( policy )
+      ,m_current( 0 )
+      ,m_peak( 0 )
+      ,m_started( 0 )
+      ,m_retired( 0 )
+      ,m_worker()
+      ,m_mutex()
+   {
+      /** At least one worker stays alive, otherwise a task pushed below the
+       *  depth threshold could stay in the queue without any worker
+       * */
+      if ( m_policy.m_minimum == 0 || m_policy.m_minimum > m_policy.m_maximum )
+      {  throw std::invalid_argument( "Invalid elastic worker limits" ); }
+      
+      for ( size_t i( 0 ); i < m_policy.m_minimum; ++i )
+      {  TryStart(); }
+   }
+   
+   void OnPush( size_t queueDepth )
+   {
+      if ( queueDepth > m_policy.m_queueDepthThreshold )
+      {  TryStart(); }
+   }
+   
+   void OnTaskStarted( std::chrono::steady_clock::duration waitTime )
+   {
+      if ( waitTime > m_policy.m_waitTimeThreshold )
+      {  TryStart(); }
+   }
+   
+   bool TryRetire()
+   {
+      auto current( m_current.load() );
+      do
+      {
+         if ( current <= m_policy.m_minimum )
+         {  return false; }
+      }
+      while ( !m_current.compare_exchange_weak( current, current - 1 ) );
+      ++m_retired;
+      return true;
+   }
+   
+   std::chrono::steady_clock::duration IdleTimeout() const
+   {  return m_policy.m_idleTimeout; }
+   
+   /** Joins all workers, the queue has to be canceled before */
+   void Join()
+   {
+      while ( 1 )
+      {
+         std::vector< std::future< void > > worker;
+         {
+            std::unique_lock< std::mutex > lock( m_mutex );
+            worker.swap( m_worker );
+         }
+         if ( worker.empty() ) { break; }
+         JoinWorker( std::move( worker ) );
+      }
+   }
+   
+   template < typename DurationType >
+   bool WaitFor( DurationType duration )
+   {
+      std::unique_lock< std::mutex > lock( m_mutex );
+      return WaitForWorker( m_worker, duration );
+   }
+   
+   WorkerScalingStatistics Statistics() const
+   {  return WorkerScalingStatistics{ m_current.load(), m_peak.load(), m_started.load(), m_retired.load() }; }
+   
+private:
+   void TryStart()
+   {
+      auto current( m_current.load() );
+      do
+      {
+         if ( current >= m_policy.m_maximum )
+         {  return; }
+      }
+      while ( !m_current.compare_exchange_weak( current, current + 1 ) );
+      
+      std::unique_lock< std::mutex > lock( m_mutex );
+      if ( m_queue.IsCanceled() ) ///< Checked within the lock, so Join cannot miss a worker
+      {
+         --m_current;
+         return;
+      }
+      
+      /** Retired workers are removed here to keep the list short */
+      m_worker.erase( std::remove_if( m_worker.begin(), m_worker.end(), []( std::future< void >& future )
+      {
+         if ( future.wait_for( std::chrono::seconds( 0 ) ) != std::future_status::ready )
+         {  return false; }
+         future.get();
+         return true;
+      } ), m_worker.end() );
+      
+      m_worker.emplace_back( std::async( std::launch::async, ElasticTaskWorker< QueueT, ElasticWorkerPool >( m_queue, *this ) ) );
+      ++m_started;
+      auto peak( m_peak.load() );
+      while ( peak < current + 1 && !m_peak.compare_exchange_weak( peak, current + 1 ) ) {}
+   }
+   
+   QueueT& m_queue;
+   ElasticWorkerPolicy const m_policy;
+   std::atomic< size_t > m_current;
+   std::atomic< size_t > m_peak;
+   std::atomic< size_t > m_started;
+   std::atomic< size_t > m_retired;
+   std::vector< std::future< void > > m_worker;
+   mutable std::mutex m_mutex;
+};
+
+/** Reports the time a task waited in the queue to the pool before it runs */
+template < typename FunctionT, typename PoolT >
+struct ElasticTask
+{
+   ElasticTask( FunctionT&& function, PoolT& pool ) : m_function( std::move( function ) ), m_pool( pool ), m_pushed( std::chrono::steady_clock::now() ) {}
+   
+   template < typename... ArgumentT >
+   auto operator()( ArgumentT&&... arguments ) -> decltype( std::declval< FunctionT& >()( std::forward< ArgumentT >( arguments )... ) )
+   {
+      m_pool.OnTaskStarted( std::chrono::steady_clock::now() - m_pushed );
+      return m_function( std::forward< ArgumentT >( arguments )... );
+   }
+   
+private:
+   FunctionT m_function;
+   PoolT& m_pool;
+   std::chrono::steady_clock::time_point m_pushed;
 };
 
 template < typename T = void >
-struct TaskProcessor : ProcessorBase< std::packaged_task< T() > >
+struct TaskProcessor : ProcessorBase< PooledTask< T > >
 {
    typedef T value_type;
-   typedef ProcessorBase< std::packaged_task< value_type() > > base_type;
+   typedef ProcessorBase< PooledTask< value_type > > base_type;
    typedef typename base_type::queue_type output_queue_type;
         
    TaskProcessor( size_t workerCount ) :
        base_type()
+      ,m_cancellation()
       ,m_worker( CreateWorker( 
           workerCount
          ,TaskWorker< output_queue_type >( this->m_output ) ) )
@@ -190,11 +1009,13 @@ struct TaskProcessor : ProcessorBase< std::packaged_task< T() > >
       Wait();
    }
    
+   /** The function is called either without arguments
+    *  or with the CancellationToken of this processor.
+    * */
    template < typename FunctionT >
    std::future< value_type > Push( FunctionT&& function )
    {
-      auto lock( this->Lock() );       
-      std::packaged_task< value_type() > task( std::move( function ) );
+      auto task( MakeTask< value_type >( MakeCancelable( std::forward< FunctionT >( function ), m_cancellation ) ) );
       auto future( task.get_future() );
       this->m_output.Push( std::move( task ) );
       return std::move( future );
@@ -206,9 +1027,11 @@ struct TaskProcessor : ProcessorBase< std::packaged_task< T() > >
       return Push( std::bind( function, std::bind( std::move< InputT& >, std::move(future.get()) ) ) );
    }
               
-   void Cancel()
+   void Cancel( CancelMode mode = CancelMode::Drain )
    {
       auto lock( this->Lock() );
+      if ( mode == CancelMode::Discard )
+      {  m_cancellation.Cancel(); } ///< Before the queue, so the draining workers skip the rest
       this->m_output.Cancel();
    }
    
@@ -218,28 +1041,67 @@ struct TaskProcessor : ProcessorBase< std::packaged_task< T() > >
       if ( !m_worker.empty() )
       {  JoinWorker( std::move( m_worker ) ); }
    }
+   
+   /** Joins the workers when they are finished within the duration */
+   template < typename DurationType >
+   bool WaitFor( DurationType duration )
+   {
+      if ( !WaitForWorker( m_worker, duration ) )
+      {  return false; }
+      Wait();
+      return true;
+   }
+   
+   /** Number of enqueued tasks not started yet */
+   size_t Pending() const
+   {  return this->m_output.Size(); }
+   
+   size_t DiscardedCount() const
+   {  return m_cancellation.DiscardedCount(); }
+   
+   CancellationToken GetToken() const
+   {  return m_cancellation.GetToken(); }
+   
+   /** Is 0 when the worker got joined already */
+   size_t WorkerCount() const
+   {  return m_worker.size(); }
          
 private:
+   CancellationSource m_cancellation;
    std::vector< std::future< void > > m_worker;
 };
    
-template < typename T = void >
-struct BufferingTaskProcessor : ProcessorBase< std::future< T > >
+/** LinkT selects the queue for the results, see LinkQueue */
+template < typename T = void, typename LinkT = MpmcLink >
+struct BufferingTaskProcessor : ProcessorBase< std::future< T >, typename LinkQueue< LinkT, std::future< T > >::type >
 {
    typedef T value_type;
-   typedef ProcessorBase< std::future< T > > base_type;
-   typedef Queue< std::packaged_task< value_type() > > input_queue_type;
+   typedef ProcessorBase< std::future< T >, typename LinkQueue< LinkT, std::future< T > >::type > base_type;
+   typedef Queue< PooledTask< value_type >, PoolAllocator< PooledTask< value_type > > > input_queue_type;
    typedef typename base_type::queue_type output_queue_type;
    
    using base_type::Pop;
    using base_type::PopOrWait;
    
-   BufferingTaskProcessor( size_t workerCount ) :
+   typedef ElasticWorkerPool< input_queue_type > pool_type;
+   
+   BufferingTaskProcessor( size_t workerCount, size_t batchSize = 1 ) :
        base_type()
-      ,m_input()
+      ,m_input( MutexSharing< output_queue_type >::Of( this->m_output ) )
+      ,m_cancellation()
       ,m_worker( CreateWorker( 
           workerCount
-         ,TaskWorker< input_queue_type >( this->m_input ) ) )
+         ,TaskWorker< input_queue_type >( this->m_input, batchSize ) ) )
+      ,m_elastic()
+   {}
+   
+   /** Elastic mode, the number of workers varies with the load */
+   BufferingTaskProcessor( ElasticWorkerPolicy policy ) :
+       base_type()
+      ,m_input( MutexSharing< output_queue_type >::Of( this->m_output ) )
+      ,m_cancellation()
+      ,m_worker()
+      ,m_elastic( std::make_unique< pool_type >( m_input, policy ) )
    {}
    
    ~BufferingTaskProcessor()
@@ -248,18 +1110,43 @@ struct BufferingTaskProcessor : ProcessorBase< std::future< T > >
       Wait();
    }
    
+   /** The function is called either without arguments
+    *  or with the CancellationToken of this processor.
+    * */
    template < typename FunctionT >
    void Push( FunctionT&& function )
    {
-      auto lock( this->Lock() );       
-      std::packaged_task< value_type() > task( std::move( function ) );
-      this->m_output.Push( std::move( task.get_future() ) );
-      this->m_input.Push( std::move( task ) );
+      if ( m_elastic )
+      {
+         PushTask( ElasticTask< std::decay_t< FunctionT >, pool_type >( std::forward< FunctionT >( function ), *m_elastic ) );
+         m_elastic->OnPush( m_input.Size() );
+      }
+      else
+      {  PushTask( std::forward< FunctionT >( function ) ); }
+   }
+   
+   /** Enqueues all tasks within a single lock of both queues */
+   template < typename FunctionT >
+   void PushBatch( std::vector< FunctionT >&& functions )
+   {
+      if ( m_elastic )
+      {
+         std::vector< ElasticTask< FunctionT, pool_type > > tasks;
+         tasks.reserve( functions.size() );
+         for ( auto& function : functions )
+         {  tasks.emplace_back( std::move( function ), *m_elastic ); }
+         PushTasks( std::move( tasks ) );
+         m_elastic->OnPush( m_input.Size() );
+      }
+      else
+      {  PushTasks( std::move( functions ) ); }
    }
               
-   void Cancel()
+   void Cancel( CancelMode mode = CancelMode::Drain )
    {
       auto lock( this->Lock() );
+      if ( mode == CancelMode::Discard )
+      {  CancelTasks(); }
       this->m_output.Cancel();
       this->m_input.Cancel();
    }
@@ -269,11 +1156,77 @@ struct BufferingTaskProcessor : ProcessorBase< std::future< T > >
       /** This is not thread save */
       if ( !m_worker.empty() )
       {  JoinWorker( std::move( m_worker ) ); }
+      if ( m_elastic )
+      {  m_elastic->Join(); }
+   }
+   
+   /** Joins the workers when they are finished within the duration */
+   template < typename DurationType >
+   bool WaitFor( DurationType duration )
+   {
+      if ( !WaitForWorker( m_worker, duration ) || ( m_elastic && !m_elastic->WaitFor( duration ) ) )
+      {  return false; }
+      Wait();
+      return true;
+   }
+   
+   WorkerScalingStatistics ScalingStatistics() const
+   {
+      if ( m_elastic )
+      {  return m_elastic->Statistics(); }
+      return WorkerScalingStatistics{ m_worker.size(), m_worker.size(), m_worker.size(), 0 };
    }
+   
+   /** Number of tasks not started yet plus number of results not taken yet */
+   size_t Pending() const
+   {  return m_input.Size() + this->m_output.Size(); }
+   
+   size_t DiscardedCount() const
+   {  return m_cancellation.DiscardedCount(); }
+   
+   CancellationToken GetToken() const
+   {  return m_cancellation.GetToken(); }
+   
+protected:
+   /** Signals running tasks and lets the workers skip enqueued 
+    *  tasks, but leaves the queues open for further pushes.
+    * */
+   void CancelTasks()
+   {  m_cancellation.Cancel(); }
          
 private:
+   /** The future is pushed to the output within the critical section of 
+    *  the input, so results are ordered like the tasks. Both queues share 
+    *  a single mutex, see MutexSharing, so it is taken once per push.
+    * */
+   template < typename FunctionT >
+   void PushTask( FunctionT&& function )
+   {
+      auto task( MakeTask< value_type >( MakeCancelable( std::forward< FunctionT >( function ), m_cancellation ) ) );
+      auto future( task.get_future() );
+      this->m_input.Push( std::move( task ), [ this, &future ]{ MutexSharing< output_queue_type >::Push( this->m_output, std::move( future ) ); } );
+   }
+   
+   template < typename FunctionT >
+   void PushTasks( std::vector< FunctionT >&& functions )
+   {
+      std::vector< PooledTask< value_type > > tasks;
+      std::vector< std::future< value_type > > futures;
+      tasks.reserve( functions.size() );
+      futures.reserve( functions.size() );
+      for ( auto& function : functions )
+      {
+         tasks.emplace_back( MakeTask< value_type >( MakeCancelable( std::move( function ), m_cancellation ) ) );
+         futures.emplace_back( tasks.back().get_future() );
+      }
+      
+      this->m_input.PushBatch( std::move( tasks ), [ this, &futures ]{ MutexSharing< output_queue_type >::PushBatch( this->m_output, std::move( futures ) ); } );
+   }
+   
    input_queue_type m_input;
+   CancellationSource m_cancellation;
    std::vector< std::future< void > > m_worker;
+   std::unique_ptr< pool_type > m_elastic;
 };
 
 
@@ -303,29 +1256,64 @@ private:
    predecessor_type& m_predecessor;
 };
   
-template < typename InputT, typename OutputT = void >
-struct DataProcessor : BufferingTaskProcessor< OutputT >
+template < typename InputT, typename OutputT = void, typename LinkT = MpmcLink >
+struct DataProcessor : BufferingTaskProcessor< OutputT, LinkT >
 {
-   typedef BufferingTaskProcessor< OutputT > base_type;
+   typedef BufferingTaskProcessor< OutputT, LinkT > base_type;
    typedef std::function< OutputT( InputT&& ) > function_type;
+   typedef std::function< OutputT( InputT&&, CancellationToken const& ) > cancelable_function_type;
    
    using base_type::Cancel;
    using base_type::Wait;
    using base_type::Pop;
    using base_type::PopOrWait;
    
-   DataProcessor( size_t workerCount, function_type function ) :
-       base_type( workerCount )
+   DataProcessor( size_t workerCount, function_type function, size_t batchSize = 1 ) :
+       base_type( workerCount, batchSize )
+      ,m_function( [ function ]( InputT&& data, CancellationToken const& ) { return function( std::move( data ) ); } )
+   {}
+   
+   DataProcessor( size_t workerCount, cancelable_function_type function, size_t batchSize = 1 ) :
+       base_type( workerCount, batchSize )
       ,m_function( function )
    {}
    
+   DataProcessor( ElasticWorkerPolicy policy, function_type function ) :
+       base_type( policy )
+      ,m_function( [ function ]( InputT&& data, CancellationToken const& ) { return function( std::move( data ) ); } )
+   {}
+   
+   DataProcessor( ElasticWorkerPolicy policy, cancelable_function_type function ) :
+       base_type( policy )
+      ,m_function( function )
+   {}
+   
+   /** The tasks refer to m_function, so they have to be done before it gets destroyed */
+   ~DataProcessor()
+   {
+      Cancel();
+      Wait();
+   }
+   
    void Push( InputT&& data )
    {
-      base_type::Push( std::bind( m_function, std::bind( std::move< InputT& >, std::move( data ) ) ) );
+      base_type::Push( Bind( std::move( data ) ) );
+   }
+   
+   void PushBatch( std::vector< InputT >&& data )
+   {
+      std::vector< decltype( Bind( std::declval< InputT >() ) ) > functions;
+      functions.reserve( data.size() );
+      for ( auto& d : data )
+      {  functions.emplace_back( Bind( std::move( d ) ) ); }
+      base_type::PushBatch( std::move( functions ) );
    }
 
 private:
-   function_type m_function;
+   auto Bind( InputT&& data ) const
+   {  return std::bind( std::cref( m_function ), std::bind( std::move< InputT& >, std::move( data ) ), std::placeholders::_1 ); }
+   
+   cancelable_function_type m_function;
 };
 
 template < typename QueueT, typename ContinuationT >
@@ -333,53 +1321,73 @@ struct ContinuationDataWorker
 {
    ContinuationDataWorker( std::atomic< bool >& canceled, QueueT& queue, ContinuationT& continuation ) : m_canceled( canceled ), m_queue( queue ), m_continuation( continuation ) {}
    
+   /** Results are moved in batches of whatever is available up to 
+    *  HandoffBatchSize, so the locks of both stages are taken once per
+    *  batch instead of once per item.
+    * */
    void operator()()
    {
+      std::vector< typename QueueT::value_type > batch;
+      batch.reserve( HandoffBatchSize );
       while ( !m_canceled.load() ) ///< When we got canceled directly, we just stop working here
       {               
          if ( m_queue.IsCanceled() ) ///< Predecessor is canceled, we takover all results and cancel then as well
          {
-            while ( 1 )
-            {
-               auto item( m_queue.Pop() ); ///< Without wait, because new items cannot be added anymore
-               if ( !item ) { break; }
-               m_continuation.Push( std::move( item.value() ) );
-            }
+            while ( m_queue.PopBatch( batch, HandoffBatchSize ) ) ///< Without wait, because new items cannot be added anymore
+            {  Handoff( batch ); }
             break;
          }
           
          /** The timeout here avoids a deadlock when between 
           *  IsCanceled and Pop the internal queue state changes
           * */
-         auto item( m_queue.PopOrWait( std::chrono::seconds( 1 ) ) );
-         if ( item ) 
-         {  m_continuation.Push( std::move( item.value() ) ); }
+         if ( m_queue.PopBatchOrWait( batch, HandoffBatchSize, std::chrono::seconds( 1 ) ) ) 
+         {  Handoff( batch ); }
+      }
+      if ( m_continuation.GetToken().IsCanceled() ) ///< Discarded, the results left in the predecessor are handed off to be skipped and counted
+      {
+         while ( m_queue.PopBatch( batch, HandoffBatchSize ) )
+         {  Handoff( batch ); }
       }
       m_continuation.Cancel(); ///< We cancel the queues not until here when the thread finishes
    }
    
 private:
+   template < typename BatchT >
+   void Handoff( BatchT& batch )
+   {
+      m_continuation.PushBatch( std::move( batch ) );
+      batch.clear();
+   }
+   
+
    std::atomic< bool >& m_canceled;
    QueueT& m_queue;
    ContinuationT& m_continuation;
 };
 
-template < typename InputT, typename OutputT = void >
-struct ContinuationDataProcessor : DataProcessor< std::future< InputT >, OutputT >
+template < typename InputT, typename OutputT = void, typename LinkT = MpmcLink >
+struct ContinuationDataProcessor : DataProcessor< std::future< InputT >, OutputT, LinkT >
 {
-   typedef DataProcessor< std::future< InputT >, OutputT > base_type;
-   typedef BufferingTaskProcessor< InputT > predecessor_type;
-   
+   typedef DataProcessor< std::future< InputT >, OutputT, LinkT > base_type;
    using typename base_type::function_type;
+   using typename base_type::cancelable_function_type;
    using base_type::Pop;
    using base_type::PopOrWait;
    
-   ContinuationDataProcessor( size_t workerCount, predecessor_type& predecessor, function_type function ) :
-       base_type( workerCount, function )
+   /** The predecessor can be any processor providing its results 
+    *  as futures of InputT in m_output, like BufferingTaskProcessor.
+    *  The function has to be convertible to either function_type 
+    *  or cancelable_function_type. The batch size is the one of 
+    *  DataProcessor.
+    * */
+   template < typename PredecessorT, typename FunctionT >
+   ContinuationDataProcessor( size_t workerCount, PredecessorT& predecessor, FunctionT function, size_t batchSize = 1 ) :
+       base_type( workerCount, std::move( function ), batchSize )
       ,m_canceled( false )
       ,m_worker( std::async( 
           std::launch::async
-         ,ContinuationDataWorker< typename predecessor_type::output_queue_type, base_type >( 
+         ,ContinuationDataWorker< typename PredecessorT::output_queue_type, base_type >( 
              m_canceled
             ,predecessor.m_output
             ,*this ) ) )
@@ -391,14 +1399,19 @@ struct ContinuationDataProcessor : DataProcessor< std::future< InputT >, OutputT
       Wait();
    }
    
-   void Cancel()
+   void Cancel( CancelMode mode = CancelMode::Drain )
    {
       /** We do not cancel the queues here directly, 
        *  because processing of already enqueued 
        *  items from predecessor would fail then.
        *  Cancelation of the queue is done in scheduler 
        *  thread right before termination.
+       *  With Discard, the scheduler thread takes over the 
+       *  results left in the predecessor, so they are skipped 
+       *  and counted like the enqueued tasks.
        */
+      if ( mode == CancelMode::Discard )
+      {  this->CancelTasks(); }
       m_canceled.store( true );
    }
    
@@ -408,8 +1421,22 @@ struct ContinuationDataProcessor : DataProcessor< std::future< InputT >, OutputT
       if ( m_worker.valid() )
       {  m_worker.get(); }
    }
+   
+   /** Waits for the scheduler thread and for the workers, 
+    *  both are joined when they are finished within the duration 
+    * */
+   template < typename DurationType >
+   bool WaitFor( DurationType duration )
+   {
+      auto const deadline( std::chrono::steady_clock::now() + duration );
+      if ( m_worker.valid() && m_worker.wait_until( deadline ) != std::future_status::ready )
+      {  return false; }
+      Wait();
+      return base_type::WaitFor( std::max( deadline - std::chrono::steady_clock::now(), std::chrono::steady_clock::duration::zero() ) );
+   }
 
 private:
+   char m_padding[ CacheLineSize ]; ///< Keeps the flag polled by the dispatcher off the lines written by the base
    std::atomic< bool > m_canceled;
    std::future< void > m_worker;
 };
@@ -417,7 +1444,7 @@ private:
 template < typename QueueT, typename FunctionT >
 struct TerminationWorker
 {
-   TerminationWorker( std::atomic< bool >& canceled, QueueT& queue, FunctionT&& function ) : m_canceled( canceled ), m_queue( queue ), m_function( function ) {}
+   TerminationWorker( std::atomic< bool >& canceled, CancellationSource& cancellation, QueueT& queue, FunctionT&& function ) : m_canceled( canceled ), m_cancellation( cancellation ), m_queue( queue ), m_function( function ) {}
    
    void operator()()
    {
@@ -425,7 +1452,7 @@ struct TerminationWorker
       {               
          if ( m_queue.IsCanceled() ) ///< Predecessor is canceled, we takeover all results and cancel then as well
          {
-            while ( 1 )
+            while ( !m_canceled.load() ) ///< Stops directly here as well
             {
                auto item( m_queue.Pop() ); ///< Without wait, because new items cannot be added anymore
                if ( !item ) { break; }     ///< The first empty item breaks
@@ -441,10 +1468,16 @@ struct TerminationWorker
          if ( item ) 
          {  m_function( std::move( item.value() ) ); }
       }
+      if ( m_cancellation.IsCanceled() ) ///< Discarded, the results left in the predecessor are counted instead of dropped silently
+      {
+         while ( m_queue.Pop() )
+         {  m_cancellation.CountDiscarded(); }
+      }
    }
    
 private:
    std::atomic< bool >& m_canceled;
+   CancellationSource& m_cancellation;
    QueueT& m_queue;
    FunctionT m_function;
 };
@@ -452,15 +1485,20 @@ private:
 template < typename InputT  = void >
 struct TerminationProcessor
 {
-   typedef BufferingTaskProcessor< InputT > predecessor_type;
    typedef std::function< void( std::future< InputT > ) > function_type;
    
-   TerminationProcessor( predecessor_type& predecessor, function_type&& function ) :
+   /** The predecessor can be any processor providing its results 
+    *  as futures of InputT in m_output, like BufferingTaskProcessor.
+    * */
+   template < typename PredecessorT >
+   TerminationProcessor( PredecessorT& predecessor, function_type&& function ) :
        m_canceled( false )
+      ,m_cancellation()
       ,m_worker( std::async( 
           std::launch::async
-         ,TerminationWorker< typename predecessor_type::output_queue_type, function_type >( 
+         ,TerminationWorker< typename PredecessorT::output_queue_type, function_type >( 
              m_canceled
+            ,m_cancellation
             ,predecessor.m_output
             ,std::forward< function_type >( function ) ) ) )
    {}
@@ -471,8 +1509,13 @@ struct TerminationProcessor
       Wait();
    }
    
-   void Cancel()
+   /** Stops directly in both modes. With Drain the results not taken over yet stay 
+    *  in the predecessor, with Discard they are taken and counted as discarded.
+    * */
+   void Cancel( CancelMode mode = CancelMode::Drain )
    {
+      if ( mode == CancelMode::Discard )
+      {  m_cancellation.Cancel(); } ///< Before the flag, so the worker sees it when it leaves
       m_canceled.store( true );
    }
    
@@ -482,8 +1525,26 @@ struct TerminationProcessor
       if ( m_worker.valid() )
       {  m_worker.get(); }
    }
+   
+   /** Joins the scheduler thread when it is finished within the duration */
+   template < typename DurationType >
+   bool WaitFor( DurationType duration )
+   {
+      if ( m_worker.valid() && m_worker.wait_for( duration ) != std::future_status::ready )
+      {  return false; }
+      Wait();
+      return true;
+   }
+   
+   /** There is no queue of its own */
+   size_t Pending() const
+   {  return 0; }
+   
+   size_t DiscardedCount() const
+   {  return m_cancellation.DiscardedCount(); }
 
 private:
    std::atomic< bool > m_canceled;
+   CancellationSource m_cancellation;
    std::future< void > m_worker;
 };
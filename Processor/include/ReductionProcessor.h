@@ -0,0 +1,250 @@
+#pragma once
+
+#include "Processor.h"
+
+#include <vector>
+#include <future>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+
+/** Accumulator of a single worker, the mutex is shared
+ *  with Flush() only, so it is uncontended most of the time.
+ * */
+template < typename AccumulatorT >
+struct PartialReduction
+{
+   PartialReduction( AccumulatorT init ) : m_accumulator( std::move( init ) ), m_failed( 0 ), m_mutex() {}
+
+   AccumulatorT m_accumulator;
+   size_t m_failed;
+   std::mutex m_mutex;
+};
+
+template < typename QueueT, typename AccumulatorT, typename AccumulateFunctionT >
+struct ReductionWorker
+{
+   ReductionWorker( std::atomic< bool >& canceled, CancellationSource& cancellation, QueueT& queue, PartialReduction< AccumulatorT >& partial, AccumulateFunctionT const& accumulate ) :
+       m_canceled( canceled )
+      ,m_cancellation( cancellation )
+      ,m_queue( queue )
+      ,m_partial( partial )
+      ,m_accumulate( accumulate )
+   {}
+
+   void operator()()
+   {
+      while ( !m_canceled.load() ) ///< When we got canceled directly, we just stop working here
+      {
+         if ( m_queue.IsCanceled() ) ///< Predecessor is canceled, we takeover our share of the results
+         {
+            while ( 1 )
+            {
+               auto item( m_queue.Pop() ); ///< Without wait, because new items cannot be added anymore
+               if ( !item ) { break; }
+               Accumulate( std::move( item.value() ) );
+            }
+            break;
+         }
+
+         /** The timeout here avoids a deadlock when between
+          *  IsCanceled and Pop the internal queue state changes
+          * */
+         auto item( m_queue.PopOrWait( std::chrono::seconds( 1 ) ) );
+         if ( item )
+         {  Accumulate( std::move( item.value() ) ); }
+      }
+      if ( m_cancellation.IsCanceled() ) ///< Discarded, the results left in the predecessor are counted instead of dropped silently
+      {
+         while ( m_queue.Pop() )
+         {  m_cancellation.CountDiscarded(); }
+      }
+   }
+
+private:
+   /** Only failed results are counted, exceptions of the accumulate 
+    *  function end the worker and are rethrown by Wait()
+    * */
+   template < typename InputT >
+   void Accumulate( std::future< InputT > future )
+   {
+      boost::optional< InputT > input;
+      try
+      {  input = future.get(); }
+      catch ( ... )
+      {
+         std::unique_lock< std::mutex > lock( m_partial.m_mutex );
+         ++m_partial.m_failed;
+         return;
+      }
+      std::unique_lock< std::mutex > lock( m_partial.m_mutex );
+      m_accumulate( m_partial.m_accumulator, std::move( input.value() ) );
+   }
+
+   std::atomic< bool >& m_canceled;
+   CancellationSource& m_cancellation;
+   QueueT& m_queue;
+   PartialReduction< AccumulatorT >& m_partial;
+   AccumulateFunctionT const& m_accumulate;
+};
+
+/** Terminal stage folding the results of its predecessor on several
+ *  workers, each one into its own partial accumulator. The partials
+ *  are merged by Flush(), either while the stream is running or after
+ *  Wait() at the end of the stream. Results holding an exception are
+ *  not accumulated but counted, see FailedCount(). An exception thrown
+ *  by the accumulate function ends its worker and is rethrown by Wait(),
+ *  the partial of the worker may be incomplete then. Several workers 
+ *  need a predecessor whose link supports several consumers.
+ * */
+template < typename InputT, typename AccumulatorT >
+struct ReductionProcessor
+{
+   typedef std::function< void( AccumulatorT&, InputT&& ) > accumulate_function_type;
+   typedef std::function< void( AccumulatorT&, AccumulatorT&& ) > merge_function_type;
+
+   template < typename PredecessorT >
+   ReductionProcessor( size_t workerCount, PredecessorT& predecessor, AccumulatorT init, accumulate_function_type accumulate, merge_function_type merge ) :
+       m_init( std::move( init ) )
+      ,m_accumulate( std::move( accumulate ) )
+      ,m_merge( std::move( merge ) )
+      ,m_canceled( false )
+      ,m_cancellation()
+      ,m_failed( 0 )
+      ,m_partial()
+      ,m_worker()
+   {
+      typedef ReductionWorker< typename PredecessorT::output_queue_type, AccumulatorT, accumulate_function_type > worker_type;
+      if ( workerCount > 1 && !QueueConcurrency< typename PredecessorT::output_queue_type >::MultipleConsumers )
+      {  throw std::invalid_argument( "Several workers cannot take the results of a predecessor with a single consumer link" ); }
+      
+      for ( size_t i( 0 ); i < workerCount; ++i )
+      {
+         m_partial.emplace_back( std::make_unique< PartialReduction< AccumulatorT > >( m_init ) );
+         m_worker.emplace_back( std::async( std::launch::async, worker_type( m_canceled, m_cancellation, predecessor.m_output, *m_partial.back(), m_accumulate ) ) );
+      }
+   }
+
+   ~ReductionProcessor()
+   {
+      Cancel();
+      Wait();
+   }
+
+   /** Stops directly in both modes. With Drain the results not taken over yet stay
+    *  in the predecessor, with Discard they are taken and counted as discarded.
+    * */
+   void Cancel( CancelMode mode = CancelMode::Drain )
+   {
+      if ( mode == CancelMode::Discard )
+      {  m_cancellation.Cancel(); } ///< Before the flag, so the workers see it when they leave
+      m_canceled.store( true );
+   }
+
+   void Wait()
+   {
+      /** This is not thread save */
+      if ( !m_worker.empty() )
+      {  JoinWorker( std::move( m_worker ) ); }
+   }
+
+   /** Joins the workers when they are finished within the duration */
+   template < typename DurationType >
+   bool WaitFor( DurationType duration )
+   {
+      if ( !WaitForWorker( m_worker, duration ) )
+      {  return false; }
+      Wait();
+      return true;
+   }
+
+   /** There is no queue of its own */
+   size_t Pending() const
+   {  return 0; }
+
+   size_t DiscardedCount() const
+   {  return m_cancellation.DiscardedCount(); }
+
+   /** Takes the partials accumulated since the last flush
+    *  and merges them in order of the workers.
+    * */
+   AccumulatorT Flush()
+   {
+      AccumulatorT result( m_init );
+      for ( auto& partial : m_partial )
+      {
+         AccumulatorT accumulator( m_init );
+         {
+            std::unique_lock< std::mutex > lock( partial->m_mutex );
+            std::swap( accumulator, partial->m_accumulator );
+            m_failed += partial->m_failed;
+            partial->m_failed = 0;
+         }
+         m_merge( result, std::move( accumulator ) );
+      }
+      return result;
+   }
+
+   /** Number of failed items up to the last flush */
+   size_t FailedCount() const
+   {  return m_failed.load(); }
+
+private:
+   AccumulatorT const m_init;
+   accumulate_function_type const m_accumulate;
+   merge_function_type const m_merge;
+   std::atomic< bool > m_canceled;
+   CancellationSource m_cancellation;
+   std::atomic< size_t > m_failed;
+   std::vector< std::unique_ptr< PartialReduction< AccumulatorT > > > m_partial;
+   std::vector< std::future< void > > m_worker;
+};
+
+/** Groups the results of the predecessor by key and folds
+ *  the items of each group into a value per key.
+ * */
+template < typename InputT, typename KeyT, typename ValueT, typename HashT = std::hash< KeyT > >
+struct KeyedReductionProcessor : ReductionProcessor< InputT, std::unordered_map< KeyT, ValueT, HashT > >
+{
+   typedef std::unordered_map< KeyT, ValueT, HashT > map_type;
+   typedef ReductionProcessor< InputT, map_type > base_type;
+   typedef std::function< KeyT( InputT const& ) > key_function_type;
+   typedef std::function< void( ValueT&, InputT&& ) > accumulate_function_type;
+   typedef std::function< void( ValueT&, ValueT&& ) > merge_function_type;
+
+   using base_type::Cancel;
+   using base_type::Wait;
+   using base_type::WaitFor;
+   using base_type::Pending;
+   using base_type::DiscardedCount;
+   using base_type::Flush;
+   using base_type::FailedCount;
+
+   /** Values of new keys are value initialized before the first item gets accumulated */
+   template < typename PredecessorT >
+   KeyedReductionProcessor( size_t workerCount, PredecessorT& predecessor, key_function_type key, accumulate_function_type accumulate, merge_function_type merge ) :
+      base_type(
+          workerCount
+         ,predecessor
+         ,map_type()
+         ,[ key, accumulate ]( map_type& map, InputT&& input )
+         {
+            auto k( key( input ) );
+            accumulate( map[ std::move( k ) ], std::move( input ) );
+         }
+         ,[ merge ]( map_type& map, map_type&& other )
+         {
+            for ( auto& entry : other )
+            {
+               auto existing( map.find( entry.first ) );
+               if ( existing == map.end() )
+               {  map.emplace( entry.first, std::move( entry.second ) ); }
+               else
+               {  merge( existing->second, std::move( entry.second ) ); }
+            }
+         } )
+   {}
+};
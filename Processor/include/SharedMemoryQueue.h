@@ -0,0 +1,400 @@
+#pragma once
+
+#include "Processor.h"
+
+#include <boost/optional/optional.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <limits>
+#include <new>
+#include <thread>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <cstdint>
+#include <cerrno>
+#include <climits>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+namespace
+{
+   /** Process shared futex, the word has to be in shared memory */
+   void FutexWait( std::atomic< std::uint32_t >& word, std::uint32_t expected, std::chrono::nanoseconds timeout )
+   {
+      auto const seconds( std::chrono::duration_cast< std::chrono::seconds >( timeout ) );
+      timespec t;
+      t.tv_sec = seconds.count();
+      t.tv_nsec = ( timeout - seconds ).count();
+      syscall( SYS_futex, reinterpret_cast< std::uint32_t* >( &word ), FUTEX_WAIT, expected, &t, nullptr, 0 );
+   }
+
+   void FutexWakeAll( std::atomic< std::uint32_t >& word )
+   {
+      syscall( SYS_futex, reinterpret_cast< std::uint32_t* >( &word ), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0 );
+   }
+}
+
+/** Bounded queue in a named POSIX shared memory segment to connect
+ *  stages running in different processes on the same host. Items are
+ *  copied into the segment once, without any serialization, so T has
+ *  to be trivially copyable and must not contain pointers.
+ *
+ *  The ring is the bounded multiple producer multiple consumer queue
+ *  of D. Vyukov, every cell has a sequence number telling whether it
+ *  is free for the producer or ready for the consumer of a position.
+ *  Blocked producers and consumers sleep on a futex, the other side
+ *  makes the system call only when somebody is waiting.
+ *
+ *  The creator owns the segment and unlinks it on destruction, other
+ *  processes open it by name. Items pushed concurrently to Cancel() may
+ *  still arrive, so consumers have to Pop() until the queue is empty.
+ * */
+template < typename T >
+struct SharedMemoryQueue
+{
+   static_assert( std::is_trivially_copyable< T >::value, "Items of a shared memory queue have to be trivially copyable" );
+
+   typedef T value_type;
+   typedef boost::optional< value_type > optional_value_type;
+
+   /** Creates the segment, the capacity is rounded up to a power of two */
+   SharedMemoryQueue( std::string const& name, size_t capacity ) :
+       m_name( name )
+      ,m_owner( true )
+      ,m_size( 0 )
+      ,m_header( nullptr )
+      ,m_cells( nullptr )
+   {
+      size_t c( 2 );
+      while ( c < capacity ) { c *= 2; }
+
+      auto const fd( shm_open( m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600 ) );
+      if ( fd == -1 )
+      {  throw std::system_error( errno, std::generic_category(), "Unable to create shared memory " + m_name ); }
+
+      m_size = sizeof( Header ) + c * sizeof( Cell );
+      if ( ftruncate( fd, m_size ) == -1 )
+      {
+         auto const error( errno );
+         close( fd );
+         shm_unlink( m_name.c_str() );
+         throw std::system_error( error, std::generic_category(), "Unable to size shared memory " + m_name );
+      }
+      Map( fd );
+
+      m_header = new ( m_header ) Header( c, sizeof( T ) );
+      for ( size_t i( 0 ); i < c; ++i )
+      {  new ( &m_cells[ i ] ) Cell( i ); }
+      m_header->m_ready.store( Header::Magic, std::memory_order_release );
+   }
+
+   /** Opens a segment created by another process */
+   explicit SharedMemoryQueue( std::string const& name ) :
+       m_name( name )
+      ,m_owner( false )
+      ,m_size( 0 )
+      ,m_header( nullptr )
+      ,m_cells( nullptr )
+   {
+      auto const fd( shm_open( m_name.c_str(), O_RDWR, 0600 ) );
+      if ( fd == -1 )
+      {  throw std::system_error( errno, std::generic_category(), "Unable to open shared memory " + m_name ); }
+
+      /** The creator may still be sizing the segment, it is empty between shm_open and ftruncate */
+      auto const deadline( std::chrono::steady_clock::now() + std::chrono::seconds( 1 ) );
+      struct stat s;
+      while ( 1 )
+      {
+         if ( fstat( fd, &s ) == -1 )
+         {
+            auto const error( errno );
+            close( fd );
+            throw std::system_error( error, std::generic_category(), "Unable to stat shared memory " + m_name );
+         }
+         if ( static_cast< size_t >( s.st_size ) >= sizeof( Header ) )
+         {  break; }
+         if ( std::chrono::steady_clock::now() > deadline )
+         {
+            close( fd );
+            throw std::invalid_argument( "Shared memory is not a queue " + m_name );
+         }
+         std::this_thread::yield();
+      }
+      m_size = s.st_size;
+      Map( fd );
+
+      /** The creator may still be initializing the ring */
+      while ( m_header->m_ready.load( std::memory_order_acquire ) != Header::Magic )
+      {
+         if ( std::chrono::steady_clock::now() > deadline )
+         {
+            munmap( m_header, m_size );
+            throw std::invalid_argument( "Shared memory queue is not initialized " + m_name );
+         }
+         std::this_thread::yield();
+      }
+      if ( m_header->m_itemSize != sizeof( T ) || m_size != sizeof( Header ) + m_header->m_capacity * sizeof( Cell ) )
+      {
+         munmap( m_header, m_size );
+         throw std::invalid_argument( "Shared memory queue has a different item type " + m_name );
+      }
+   }
+
+   ~SharedMemoryQueue()
+   {
+      munmap( m_header, m_size );
+      if ( m_owner )
+      {  shm_unlink( m_name.c_str() ); }
+   }
+
+   SharedMemoryQueue( SharedMemoryQueue const& ) = delete;
+   SharedMemoryQueue& operator=( SharedMemoryQueue const& ) = delete;
+
+   size_t Capacity() const
+   {  return m_header->m_capacity; }
+
+   bool IsCanceled() const
+   {  return m_header->m_canceled.load() != 0; }
+
+   /** Approximation only, when there are concurrent pushes or pops */
+   size_t Size() const
+   {
+      auto const dequeue( m_header->m_dequeue.load() );
+      auto const enqueue( m_header->m_enqueue.load() );
+      return enqueue > dequeue ? enqueue - dequeue : 0;
+   }
+
+   /** Wakes up all waiting producers and consumers of all processes */
+   void Cancel()
+   {
+      m_header->m_canceled.store( 1 );
+      ++m_header->m_pushed;
+      ++m_header->m_popped;
+      FutexWakeAll( m_header->m_pushed );
+      FutexWakeAll( m_header->m_popped );
+   }
+
+   /** Returns false when the queue is full */
+   bool TryPush( T const& item )
+   {
+      if ( IsCanceled() )
+      {  throw std::logic_error( "Queue already canceled" ); }
+
+      if ( !Enqueue( item ) )
+      {  return false; }
+
+      ++m_header->m_pushed;
+      if ( m_header->m_consumersWaiting.load() != 0 )
+      {  FutexWakeAll( m_header->m_pushed ); }
+      return true;
+   }
+
+   /** Waits while the queue is full */
+   void Push( T const& item )
+   {
+      while ( !TryPush( item ) )
+      {
+         Wait( m_header->m_popped, m_header->m_producersWaiting, std::chrono::seconds( 1 ), [ this ]
+         {  return Size() < Capacity() || IsCanceled(); } );
+      }
+   }
+
+   void PushBatch( std::vector< T >&& items )
+   {
+      for ( auto const& item : items )
+      {  Push( item ); }
+   }
+
+   optional_value_type Pop()
+   {
+      T item;
+      if ( !Dequeue( item ) )
+      {  return optional_value_type(); }
+
+      ++m_header->m_popped;
+      if ( m_header->m_producersWaiting.load() != 0 )
+      {  FutexWakeAll( m_header->m_popped ); }
+      return optional_value_type( item );
+   }
+
+   size_t PopBatch( std::vector< T >& batch, size_t maximum )
+   {
+      size_t count( 0 );
+      for ( ; count < maximum; ++count )
+      {
+         auto item( Pop() );
+         if ( !item ) { break; }
+         batch.emplace_back( item.value() );
+      }
+      return count;
+   }
+
+   template < typename DurationType = std::chrono::seconds >
+   optional_value_type PopOrWait( DurationType duration = GetMax< DurationType >() )
+   {
+      auto const deadline( std::chrono::steady_clock::now() + duration );
+      while ( 1 )
+      {
+         auto item( Pop() );
+         if ( item )
+         {  return item; }
+         if ( IsCanceled() ) ///< The last items may have been pushed right before the cancellation, after we looked
+         {  return Pop(); }
+         auto const now( std::chrono::steady_clock::now() );
+         if ( now >= deadline )
+         {  return item; }
+
+         Wait( m_header->m_pushed, m_header->m_consumersWaiting, deadline - now, [ this ]
+         {  return Size() > 0 || IsCanceled(); } );
+      }
+   }
+
+   /** Returns 0 without waiting when maximum is 0 */
+   template < typename DurationType = std::chrono::seconds >
+   size_t PopBatchOrWait( std::vector< T >& batch, size_t maximum, DurationType duration = GetMax< DurationType >() )
+   {
+      if ( maximum == 0 )
+      {  return 0; }
+      
+      auto item( PopOrWait( duration ) );
+      if ( !item )
+      {  return 0; }
+      batch.emplace_back( item.value() );
+      return 1 + PopBatch( batch, maximum - 1 );
+   }
+
+private:
+   struct Cell
+   {
+      explicit Cell( size_t sequence ) : m_sequence( sequence ), m_item() {}
+
+      std::atomic< std::uint64_t > m_sequence;
+      T m_item;
+   };
+
+   /** Producer and consumer positions are kept on separate cache lines */
+   struct Header
+   {
+      static std::uint32_t const Magic = 0x51554555; ///< "QUEU"
+
+      Header( size_t capacity, size_t itemSize ) :
+          m_ready( 0 )
+         ,m_capacity( capacity )
+         ,m_itemSize( itemSize )
+         ,m_canceled( 0 )
+         ,m_enqueue( 0 )
+         ,m_pushed( 0 )
+         ,m_consumersWaiting( 0 )
+         ,m_dequeue( 0 )
+         ,m_popped( 0 )
+         ,m_producersWaiting( 0 )
+      {}
+
+      std::atomic< std::uint32_t > m_ready;
+      std::uint64_t const m_capacity;
+      std::uint64_t const m_itemSize;
+      std::atomic< std::uint32_t > m_canceled;
+      char m_padding0[ CacheLineSize ];
+      std::atomic< std::uint64_t > m_enqueue;
+      std::atomic< std::uint32_t > m_pushed;           ///< Futex word of waiting consumers
+      std::atomic< std::uint32_t > m_consumersWaiting;
+      char m_padding1[ CacheLineSize ];
+      std::atomic< std::uint64_t > m_dequeue;
+      std::atomic< std::uint32_t > m_popped;           ///< Futex word of waiting producers
+      std::atomic< std::uint32_t > m_producersWaiting;
+      char m_padding2[ CacheLineSize ];
+   };
+
+   static_assert( ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "Atomics in shared memory have to be lock free" );
+
+   void Map( int fd )
+   {
+      auto const memory( mmap( nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 ) );
+      auto const error( errno );
+      close( fd );
+      if ( memory == MAP_FAILED )
+      {
+         if ( m_owner ) { shm_unlink( m_name.c_str() ); }
+         throw std::system_error( error, std::generic_category(), "Unable to map shared memory " + m_name );
+      }
+      m_header = static_cast< Header* >( memory );
+      m_cells = reinterpret_cast< Cell* >( static_cast< char* >( memory ) + sizeof( Header ) );
+   }
+
+   bool Enqueue( T const& item )
+   {
+      auto const mask( m_header->m_capacity - 1 );
+      auto position( m_header->m_enqueue.load( std::memory_order_relaxed ) );
+      while ( 1 )
+      {
+         auto& cell( m_cells[ position & mask ] );
+         auto const difference( static_cast< std::int64_t >( cell.m_sequence.load( std::memory_order_acquire ) - position ) );
+         if ( difference == 0 )
+         {
+            if ( m_header->m_enqueue.compare_exchange_weak( position, position + 1, std::memory_order_relaxed ) )
+            {
+               cell.m_item = item;
+               cell.m_sequence.store( position + 1, std::memory_order_release );
+               return true;
+            }
+         }
+         else if ( difference < 0 ) ///< The consumer of the previous round did not take it yet
+         {  return false; }
+         else
+         {  position = m_header->m_enqueue.load( std::memory_order_relaxed ); }
+      }
+   }
+
+   bool Dequeue( T& item )
+   {
+      auto const mask( m_header->m_capacity - 1 );
+      auto position( m_header->m_dequeue.load( std::memory_order_relaxed ) );
+      while ( 1 )
+      {
+         auto& cell( m_cells[ position & mask ] );
+         auto const difference( static_cast< std::int64_t >( cell.m_sequence.load( std::memory_order_acquire ) - ( position + 1 ) ) );
+         if ( difference == 0 )
+         {
+            if ( m_header->m_dequeue.compare_exchange_weak( position, position + 1, std::memory_order_relaxed ) )
+            {
+               item = cell.m_item;
+               cell.m_sequence.store( position + mask + 1, std::memory_order_release );
+               return true;
+            }
+         }
+         else if ( difference < 0 ) ///< The producer did not fill it yet
+         {  return false; }
+         else
+         {  position = m_header->m_dequeue.load( std::memory_order_relaxed ); }
+      }
+   }
+
+   /** The futex word is read before the condition is checked, so a change
+    *  in between lets the wait return immediately. The other side wakes up
+    *  only when it sees the waiting counter, which is raised before.
+    * */
+   template < typename DurationType, typename PredicateT >
+   void Wait( std::atomic< std::uint32_t >& word, std::atomic< std::uint32_t >& waiting, DurationType duration, PredicateT ready )
+   {
+      ++waiting;
+      auto const expected( word.load() );
+      if ( !ready() )
+      {  FutexWait( word, expected, std::chrono::duration_cast< std::chrono::nanoseconds >( duration ) ); }
+      --waiting;
+   }
+
+   std::string const m_name;
+   bool const m_owner;
+   size_t m_size;
+   Header* m_header;
+   Cell* m_cells;
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "Processor.h"
+
+#include <vector>
+#include <chrono>
+#include <numeric>
+#include <algorithm>
+#include <functional>
+
+struct StageProgress
+{
+   size_t m_pending;   ///< Items in the queues of the stage
+   size_t m_discarded; ///< Tasks skipped after the deadline was hit
+   bool m_done;
+};
+
+struct ShutdownReport
+{
+   size_t Pending() const
+   {  return std::accumulate( m_stages.begin(), m_stages.end(), size_t( 0 ), []( size_t sum, StageProgress const& stage ) { return sum + stage.m_pending; } ); }
+   
+   size_t Discarded() const
+   {  return std::accumulate( m_stages.begin(), m_stages.end(), size_t( 0 ), []( size_t sum, StageProgress const& stage ) { return sum + stage.m_discarded; } ); }
+   
+   std::vector< StageProgress > m_stages;
+   bool m_timedOut;
+};
+
+/** Coordinated shutdown of a chain of processors within a deadline.
+ *  The stages have to be given in the order of the chain: Only the 
+ *  first one gets canceled, the others follow stage by stage when 
+ *  their predecessor is finished, so all enqueued items are processed. 
+ *  When the deadline is hit, all remaining stages are canceled with 
+ *  CancelMode::Discard, last stage first. Enqueued tasks are skipped 
+ *  and counted then, results left in a predecessor are taken over by 
+ *  its successor and counted there. Running tasks get the grace period 
+ *  to follow their token, stages still running then are reported as not 
+ *  done and Drain() returns without waiting for them.
+ *  The progress function is called periodically while draining and 
+ *  with the final report.
+ * */
+struct Shutdown
+{
+   typedef std::chrono::steady_clock clock_type;
+   typedef std::function< void( ShutdownReport const& ) > progress_function_type;
+   
+   Shutdown( clock_type::duration timeout, clock_type::duration interval = std::chrono::milliseconds( 100 ), progress_function_type progress = progress_function_type(), clock_type::duration grace = std::chrono::seconds( 1 ) ) :
+       m_timeout( timeout )
+      ,m_interval( interval )
+      ,m_progress( std::move( progress ) )
+      ,m_grace( grace )
+   {}
+   
+   template < typename... StageT >
+   ShutdownReport Drain( StageT&... stages )
+   {
+      std::vector< Stage > chain{ Stage( stages )... };
+      auto const deadline( clock_type::now() + m_timeout );
+      ShutdownReport report{ std::vector< StageProgress >( chain.size(), StageProgress{ 0, 0, false } ), false };
+      
+      if ( !chain.empty() )
+      {  chain.front().m_cancel( CancelMode::Drain ); }
+      
+      for ( size_t i( 0 ); i < chain.size() && !report.m_timedOut; ++i )
+      {
+         while ( !chain[ i ].m_waitFor( std::max( clock_type::duration::zero(), std::min( m_interval, deadline - clock_type::now() ) ) ) )
+         {
+            Update( chain, report );
+            if ( clock_type::now() >= deadline )
+            {
+               report.m_timedOut = true;
+               break;
+            }
+            Report( report );
+         }
+         report.m_stages[ i ].m_done = !report.m_timedOut;
+      }
+      
+      if ( report.m_timedOut )
+      {
+         /** Last stage first, so no stage starts another task with 
+          *  a result its predecessor provides while being discarded
+          * */
+         for ( size_t i( chain.size() ); i > 0; --i )
+         {
+            if ( !report.m_stages[ i - 1 ].m_done )
+            {  chain[ i - 1 ].m_cancel( CancelMode::Discard ); }
+         }
+         auto const graceDeadline( clock_type::now() + m_grace );
+         bool graceExpired( false );
+         for ( size_t i( 0 ); i < chain.size() && !graceExpired; ++i )
+         {
+            if ( report.m_stages[ i ].m_done )
+            {  continue; }
+            
+            /** Running tasks only, they have been signaled via their token */
+            while ( !chain[ i ].m_waitFor( std::max( clock_type::duration::zero(), std::min( m_interval, graceDeadline - clock_type::now() ) ) ) )
+            {
+               Update( chain, report );
+               if ( clock_type::now() >= graceDeadline ) ///< A task ignoring its token, the stage stays not done
+               {
+                  graceExpired = true;
+                  break;
+               }
+               Report( report );
+            }
+            report.m_stages[ i ].m_done = !graceExpired;
+         }
+      }
+      Update( chain, report );
+      Report( report );
+      return report;
+   }
+   
+private:
+   /** Type erased interface of a processor */
+   struct Stage
+   {
+      template < typename StageT >
+      Stage( StageT& stage ) :
+          m_cancel( [ &stage ]( CancelMode mode ) { stage.Cancel( mode ); } )
+         ,m_waitFor( [ &stage ]( clock_type::duration duration ) { return stage.WaitFor( duration ); } )
+         ,m_pending( [ &stage ] { return stage.Pending(); } )
+         ,m_discarded( [ &stage ] { return stage.DiscardedCount(); } )
+      {}
+      
+      std::function< void( CancelMode ) > m_cancel;
+      std::function< bool( clock_type::duration ) > m_waitFor;
+      std::function< size_t() > m_pending;
+      std::function< size_t() > m_discarded;
+   };
+   
+   static void Update( std::vector< Stage > const& chain, ShutdownReport& report )
+   {
+      for ( size_t i( 0 ); i < chain.size(); ++i )
+      {
+         report.m_stages[ i ].m_pending = chain[ i ].m_pending();
+         report.m_stages[ i ].m_discarded = chain[ i ].m_discarded();
+      }
+   }
+   
+   void Report( ShutdownReport const& report ) const
+   {
+      if ( m_progress )
+      {  m_progress( report ); }
+   }
+   
+   clock_type::duration const m_timeout;
+   clock_type::duration const m_interval;
+   progress_function_type const m_progress;
+   clock_type::duration const m_grace;
+};
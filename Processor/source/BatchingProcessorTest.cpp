@@ -0,0 +1,114 @@
+
+#include "../include/BatchingProcessor.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <numeric>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <stdexcept>
+
+TEST( BatchingProcessor, ConstructDestroy )
+{
+   DataProcessor< int, int > a( 1, []( int i ) { return i; } );
+   BatchingProcessor< int > b( a, 10, std::chrono::milliseconds( 10 ) );
+}
+
+TEST( BatchingProcessor, InvalidCount )
+{
+   DataProcessor< int, int > a( 1, []( int i ) { return i; } );
+   EXPECT_THROW( BatchingProcessor< int >( a, 0, std::chrono::milliseconds( 10 ) ), std::invalid_argument );
+}
+
+TEST( BatchingProcessor, MaxCount )
+{
+   DataProcessor< int, int > a( 2, []( int i ) { return i; } );
+   BatchingProcessor< int > b( a, 4, std::chrono::seconds( 10 ) );
+   for ( int no( 0 ); no < 10; ++no ) { a.Push( int( no ) ); }
+   EXPECT_EQ( std::vector< int >( { 0, 1, 2, 3 } ), b.PopOrWait()->get() );
+   EXPECT_EQ( std::vector< int >( { 4, 5, 6, 7 } ), b.PopOrWait()->get() );
+   a.Cancel(); ///< Cancel first, remaining items are provided as last batch
+   b.Wait();   ///< Wait for last
+   EXPECT_EQ( std::vector< int >( { 8, 9 } ), b.PopOrWait()->get() );
+   EXPECT_FALSE( b.Pop() );
+}
+
+TEST( BatchingProcessor, MaxDelay )
+{
+   std::promise< void > release;
+   auto const released( release.get_future().share() );
+   DataProcessor< int, int > a( 2, [ released ]( int i )
+   {
+      if ( i == 5 )
+      {  released.wait(); } ///< Blocked until the first batch got provided
+      return i;
+   } );
+   BatchingProcessor< int > b( a, 100, std::chrono::milliseconds( 10 ) );
+   a.Push( 23 );
+   a.Push( 5 );
+   auto first( b.PopOrWait( std::chrono::seconds( 10 ) ) ); ///< Provided by maxDelay without waiting for 5
+   release.set_value();
+   ASSERT_TRUE( (bool)first );
+   EXPECT_EQ( std::vector< int >( { 23 } ), first->get() );
+   EXPECT_EQ( std::vector< int >( { 5 } ), b.PopOrWait()->get() );
+   a.Cancel();
+   b.Wait();
+}
+
+TEST( BatchingProcessor, CancelWithPendingItem )
+{
+   std::promise< void > release;
+   auto const released( release.get_future().share() );
+   DataProcessor< int, int > a( 1, [ released ]( int i ) { released.wait(); return i; } );
+   BatchingProcessor< int > b( a, 100, std::chrono::seconds( 10 ) );
+   a.Push( 23 );
+   while ( a.m_output.Size() > 0 ) ///< Until the batching worker took the future, the item is not ready yet
+   {  std::this_thread::yield(); }
+   b.Cancel(); ///< Drain
+   EXPECT_FALSE( b.WaitFor( std::chrono::milliseconds( 1500 ) ) ); ///< The worker leaves its loop after its 1s wait, but has to wait for the item then
+   release.set_value();
+   b.Wait();
+   auto batch( b.Pop() );
+   ASSERT_TRUE( (bool)batch );
+   EXPECT_EQ( std::vector< int >( { 23 } ), batch->get() );
+   EXPECT_EQ( 0u, b.DiscardedCount() );
+   a.Cancel();
+   a.Wait();
+}
+
+TEST( BatchingProcessor, Throw )
+{
+   DataProcessor< int, int > a( 1, []( int i )
+   {
+      if ( i == 5 )
+      {  throw std::exception(); }
+      return i;
+   } );
+   BatchingProcessor< int > b( a, 3, std::chrono::seconds( 10 ) );
+   for ( auto i : { 23, 7, 5, 42 } ) { a.Push( std::move( i ) ); }
+   a.Cancel();
+   b.Wait();
+   EXPECT_EQ( std::vector< int >( { 23, 7 } ), b.Pop()->get() );
+   EXPECT_THROW( b.Pop()->get(), std::exception );
+   EXPECT_EQ( std::vector< int >( { 42 } ), b.Pop()->get() );
+   EXPECT_FALSE( b.Pop() );
+}
+
+TEST( BatchingProcessor, Continuation )
+{
+   std::vector< int > sums;
+   DataProcessor< int, int > a( 2, []( int i ) { return i; } );
+   BatchingProcessor< int > b( a, 10, std::chrono::seconds( 10 ) );
+   ContinuationDataProcessor< std::vector< int >, int > c( 2, b, []( std::future< std::vector< int > > batch )
+   {
+      auto values( batch.get() );
+      return std::accumulate( values.begin(), values.end(), 0 );
+   } );
+   TerminationProcessor< int > d( c, [ &sums ]( std::future< int > sum ) { sums.emplace_back( sum.get() ); } );
+   for ( int no( 0 ); no < 30; ++no ) { a.Push( int( no ) ); }
+   a.Cancel(); ///< Cancel first
+   d.Wait();   ///< Wait for last
+   EXPECT_EQ( std::vector< int >( { 45, 145, 245 } ), sums );
+}
@@ -0,0 +1,123 @@
+
+#include "../include/ExpectedDataProcessor.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+TEST( Expected, ValueAndError )
+{
+   Expected< int > value( 23 );
+   EXPECT_TRUE( value.HasValue() );
+   EXPECT_EQ( 23, value.Value() );
+   
+   Expected< int > error( MakeUnexpected( std::make_exception_ptr( std::runtime_error( "error" ) ) ) );
+   EXPECT_FALSE( error.HasValue() );
+   EXPECT_TRUE( (bool)error.Error() );
+   EXPECT_THROW( error.Value(), std::runtime_error );
+   
+   Expected< std::string, int > code( MakeUnexpected( 5 ) );
+   EXPECT_EQ( 5, code.Error() );
+   EXPECT_THROW( code.Value(), std::logic_error );
+   
+   Expected< void, int > done;
+   EXPECT_TRUE( done.HasValue() );
+   EXPECT_NO_THROW( done.Value() );
+}
+
+TEST( ExpectedDataProcessor, PushPop )
+{
+   ExpectedDataProcessor< int, int, std::string > processor( 2, []( int i ) -> Expected< int, std::string >
+   {
+      if ( i == 5 )
+      {  return MakeUnexpected( std::string( "five" ) ); }
+      return i * 2;
+   } );
+   processor.Push( 23 );
+   processor.Push(  5 );
+   processor.Push(  7 );
+   EXPECT_EQ( 46, processor.PopOrWait()->get().Value() );
+   EXPECT_EQ( "five", processor.PopOrWait()->get().Error() );
+   EXPECT_EQ( 14, processor.PopOrWait()->get().Value() );
+}
+
+TEST( ExpectedDataProcessor, ThrowBecomesError )
+{
+   ExpectedDataProcessor< int, int > processor( 1, []( int i ) -> Expected< int >
+   {
+      if ( i == 5 )
+      {  throw std::runtime_error( "five" ); }
+      return i;
+   } );
+   processor.Push( 5 );
+   auto result( processor.PopOrWait()->get() ); ///< Does not throw
+   EXPECT_FALSE( result.HasValue() );
+   EXPECT_THROW( std::rethrow_exception( result.Error() ), std::runtime_error );
+}
+
+TEST( ExpectedContinuationDataProcessor, SkipFailedAndDeadLetter )
+{
+   std::atomic< int > called( 0 );
+   std::mutex mutex; ///< Dead letter functions run concurrently on the worker threads of a and b
+   std::vector< std::string > deadLetters;
+   std::vector< int > values;
+   ExpectedDataProcessor< int, int, std::string > a( 2, []( int i ) -> Expected< int, std::string >
+   {
+      if ( i == 5 )
+      {  return MakeUnexpected( std::string( "five" ) ); }
+      return i;
+   }
+   ,[ &mutex, &deadLetters ]( std::string const& error ) 
+   {
+      std::lock_guard< std::mutex > lock( mutex );
+      deadLetters.emplace_back( "a: " + error ); 
+   } );
+   ExpectedContinuationDataProcessor< int, int, std::string > b( 1, a, [ &called ]( int i ) -> Expected< int, std::string >
+   {
+      ++called;
+      if ( i == 7 )
+      {  return MakeUnexpected( std::string( "seven" ) ); }
+      return i * 2;
+   }
+   ,[ &mutex, &deadLetters ]( std::string const& error ) 
+   {
+      std::lock_guard< std::mutex > lock( mutex );
+      deadLetters.emplace_back( "b: " + error ); 
+   } );
+   TerminationProcessor< Expected< int, std::string > > c( b, [ &values ]( std::future< Expected< int, std::string > > input )
+   {
+      auto result( input.get() );
+      if ( result )
+      {  values.emplace_back( result.Value() ); }
+   } );
+   for ( auto i : { 23, 5, 7, 5, 42 } ) { a.Push( std::move( i ) ); }
+   a.Cancel(); ///< Cancel first
+   c.Wait();   ///< Wait for last
+   EXPECT_EQ( 3, called.load() );
+   EXPECT_EQ( std::vector< int >( { 46, 84 } ), values );
+   std::sort( deadLetters.begin(), deadLetters.end() );
+   EXPECT_EQ( std::vector< std::string >( { "a: five", "a: five", "b: seven" } ), deadLetters );
+}
+
+TEST( ExpectedContinuationDataProcessor, ThrowingPredecessor )
+{
+   BufferingTaskProcessor< Expected< int > > a( 1 );
+   std::atomic< int > deadLetters( 0 );
+   ExpectedContinuationDataProcessor< int, std::string > b( 1, a, []( int i ) -> Expected< std::string >
+   {  return std::to_string( i ); }
+   ,[ &deadLetters ]( std::exception_ptr const& ) { ++deadLetters; } );
+   a.Push( []{ return Expected< int >( 23 ); } );
+   a.Push( []() -> Expected< int > { throw std::runtime_error( "error" ); } );
+   EXPECT_EQ( "23", b.PopOrWait()->get().Value() );
+   auto result( b.PopOrWait()->get() ); ///< Exceptions in the futures of the predecessor become errors
+   EXPECT_FALSE( result.HasValue() );
+   EXPECT_THROW( result.Value(), std::runtime_error );
+   EXPECT_EQ( 1, deadLetters.load() ); ///< Converted in b, so dead lettered there
+   a.Cancel();
+   b.Wait();
+}
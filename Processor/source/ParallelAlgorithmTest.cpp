@@ -0,0 +1,107 @@
+
+#include "../include/ParallelAlgorithm.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <numeric>
+#include <random>
+#include <atomic>
+#include <stdexcept>
+
+TEST( ParallelAlgorithm, ForEach )
+{
+   TaskProcessor<> processor( 4 );
+   std::vector< int > values( 100000, 1 );
+   ParallelFor( processor, values.begin(), values.end(), []( int& v ) { v *= 3; } );
+   EXPECT_EQ( 300000, std::accumulate( values.begin(), values.end(), 0 ) );
+}
+
+TEST( ParallelAlgorithm, ForEachEmpty )
+{
+   TaskProcessor<> processor( 2 );
+   std::vector< int > values;
+   EXPECT_NO_THROW( ParallelFor( processor, values.begin(), values.end(), []( int& v ) { ++v; } ) );
+}
+
+TEST( ParallelAlgorithm, ForEachGrainSize )
+{
+   TaskProcessor<> processor( 4 );
+   std::atomic< int > called( 0 );
+   std::vector< int > values( 1000, 1 );
+   ParallelFor( processor, values.begin(), values.end(), [ &called ]( int& v ) { ++called; v = 2; }, 10 );
+   EXPECT_EQ( 1000, called.load() );
+   EXPECT_EQ( 2000, std::accumulate( values.begin(), values.end(), 0 ) );
+}
+
+TEST( ParallelAlgorithm, Transform )
+{
+   TaskProcessor<> processor( 4 );
+   std::vector< int > input( 50000 );
+   std::iota( input.begin(), input.end(), 0 );
+   std::vector< long long > output( input.size() );
+   auto end( ParallelTransform( processor, input.begin(), input.end(), output.begin(), []( int v ) { return 2ll * v; } ) );
+   EXPECT_TRUE( end == output.end() );
+   for ( size_t i( 0 ); i < input.size(); ++i )
+   {  EXPECT_EQ( 2ll * input[ i ], output[ i ] ); }
+}
+
+TEST( ParallelAlgorithm, Reduce )
+{
+   TaskProcessor<> processor( 4 );
+   std::vector< long long > values( 100000 );
+   std::iota( values.begin(), values.end(), 1 );
+   EXPECT_EQ( 100000ll * 100001 / 2, ParallelReduce( processor, values.begin(), values.end(), 0ll ) );
+   EXPECT_EQ( 23ll, ParallelReduce( processor, values.begin(), values.begin(), 23ll ) );
+}
+
+TEST( ParallelAlgorithm, ReduceKeepsOrder )
+{
+   TaskProcessor<> processor( 4 );
+   std::vector< std::string > values;
+   for ( int i( 0 ); i < 1000; ++i ) { values.emplace_back( std::to_string( i % 10 ) ); }
+   auto const expected( std::accumulate( values.begin(), values.end(), std::string( ">" ) ) );
+   EXPECT_EQ( expected, ParallelReduce( processor, values.begin(), values.end(), std::string( ">" ), std::plus<>(), 7 ) );
+}
+
+TEST( ParallelAlgorithm, Sort )
+{
+   TaskProcessor<> processor( 4 );
+   std::mt19937 generator( 23 );
+   std::vector< int > values( 100000 );
+   std::generate( values.begin(), values.end(), generator );
+   auto expected( values );
+   std::sort( expected.begin(), expected.end() );
+   ParallelSort( processor, values.begin(), values.end() );
+   EXPECT_EQ( expected, values );
+}
+
+TEST( ParallelAlgorithm, SortGrainSizeAndCompare )
+{
+   TaskProcessor<> processor( 3 );
+   std::vector< int > values( 1001 );
+   std::iota( values.begin(), values.end(), 0 );
+   ParallelSort( processor, values.begin(), values.end(), std::greater<>(), 13 );
+   EXPECT_TRUE( std::is_sorted( values.begin(), values.end(), std::greater<>() ) );
+}
+
+TEST( ParallelAlgorithm, Throw )
+{
+   TaskProcessor<> processor( 4 );
+   std::vector< int > values( 1000 );
+   std::iota( values.begin(), values.end(), 0 );
+   EXPECT_THROW( ParallelFor( processor, values.begin(), values.end(), []( int v ) 
+   {
+      if ( v == 500 )
+      {  throw std::runtime_error( "500" ); } 
+   }, 10 ), std::runtime_error );
+}
+
+TEST( ParallelAlgorithm, JoinedProcessorRunsInline )
+{
+   TaskProcessor<> processor( 2 );
+   processor.Cancel();
+   processor.Wait();
+   std::vector< int > values( 1000, 1 );
+   EXPECT_EQ( 1000, ParallelReduce( processor, values.begin(), values.end(), 0, std::plus<>(), 10 ) );
+}
@@ -0,0 +1,131 @@
+
+#include "../include/PartitionedDataProcessor.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+
+typedef std::pair< int, int > KeyAndSequence;
+
+TEST( PartitionedDataProcessor, ConstructDestroy )
+{
+   PartitionedDataProcessor< int, int, int > processor( 2, []( int const& i ) { return i; }, []( int i ) { return i; } );
+}
+
+TEST( PartitionedDataProcessor, InvalidLaneCount )
+{
+   EXPECT_THROW( ( PartitionedDataProcessor< int, int, int >( 0, []( int const& i ) { return i; }, []( int i ) { return i; } ) ), std::invalid_argument );
+}
+
+TEST( PartitionedDataProcessor, OrderPerKey )
+{
+   PartitionedDataProcessor< int, KeyAndSequence, KeyAndSequence > processor( 4
+      ,[]( KeyAndSequence const& item ) { return item.first; }
+      ,[]( KeyAndSequence item ) 
+      {
+         if ( item.first % 3 == 0 ) { std::this_thread::yield(); }
+         return item; 
+      } );
+   for ( int sequence( 0 ); sequence < 50; ++sequence )
+   {
+      for ( int key( 0 ); key < 10; ++key )
+      {  processor.Push( KeyAndSequence( key, sequence ) ); }
+   }
+   std::map< int, int > next;
+   for ( int no( 0 ); no < 500; ++no )
+   {
+      auto item( processor.PopOrWait()->get() );
+      EXPECT_EQ( next[ item.first ]++, item.second );
+   }
+   EXPECT_EQ( 10u, next.size() );
+}
+
+TEST( PartitionedDataProcessor, SameKeySameWorker )
+{
+   std::mutex mutex;
+   std::map< int, std::thread::id > workerPerKey;
+   bool sameWorker( true );
+   PartitionedDataProcessor< int, int > processor( 3
+      ,[]( int const& i ) { return i % 7; }
+      ,[ & ]( int i ) 
+      {
+         std::unique_lock< std::mutex > lock( mutex );
+         auto inserted( workerPerKey.emplace( i % 7, std::this_thread::get_id() ) );
+         sameWorker &= inserted.first->second == std::this_thread::get_id();
+      } );
+   for ( int no( 0 ); no < 100; ++no ) { processor.Push( int( no ) ); }
+   processor.Cancel();
+   processor.Wait();
+   EXPECT_TRUE( sameWorker );
+   EXPECT_EQ( 7u, workerPerKey.size() );
+}
+
+TEST( PartitionedDataProcessor, Throw )
+{
+   PartitionedDataProcessor< int, int, int > processor( 2
+      ,[]( int const& i ) { return 0; }
+      ,[]( int i ) 
+      {
+         if ( i == 5 )
+         {  throw std::exception(); }
+         return i;
+      } );
+   processor.Push( 3 );
+   processor.Push( 5 );
+   processor.Push( 7 );
+   EXPECT_EQ( 3, processor.PopOrWait()->get() );
+   EXPECT_THROW( processor.PopOrWait()->get(), std::exception );
+   EXPECT_EQ( 7, processor.PopOrWait()->get() );
+}
+
+TEST( PartitionedDataProcessor, Continuation )
+{
+   std::map< int, std::vector< int > > values;
+   PartitionedDataProcessor< int, KeyAndSequence, KeyAndSequence > a( 4
+      ,[]( KeyAndSequence const& item ) { return item.first; }
+      ,[]( KeyAndSequence item ) { return item; } );
+   ContinuationDataProcessor< KeyAndSequence, KeyAndSequence > b( 1, a, []( std::future< KeyAndSequence > item )
+   {
+      auto v( item.get() );
+      v.second *= 2;
+      return v;
+   } );
+   TerminationProcessor< KeyAndSequence > c( b, [ &values ]( std::future< KeyAndSequence > item )
+   {
+      auto v( item.get() );
+      values[ v.first ].emplace_back( v.second );
+   } );
+   for ( int sequence( 0 ); sequence < 20; ++sequence )
+   {
+      for ( int key( 0 ); key < 5; ++key )
+      {  a.Push( KeyAndSequence( key, sequence ) ); }
+   }
+   a.Cancel(); ///< Cancel first, output is canceled when all lanes are done
+   c.Wait();   ///< Wait for last
+   EXPECT_EQ( 5u, values.size() );
+   for ( auto const& entry : values )
+   {
+      std::vector< int > expected;
+      for ( int sequence( 0 ); sequence < 20; ++sequence ) { expected.emplace_back( sequence * 2 ); }
+      EXPECT_EQ( expected, entry.second );
+   }
+}
+
+TEST( PartitionedDataProcessor, MpscLink )
+{
+   std::atomic< int > sum( 0 );
+   PartitionedDataProcessor< int, int, int, std::hash< int >, MpscLink > a( 4
+      ,[]( int const& item ) { return item; }
+      ,[]( int item ) { return item; } );
+   TerminationProcessor< int > b( a, [ &sum ]( std::future< int > item ) { sum += item.get(); } );
+   for ( int i( 1 ); i <= 100; ++i )
+   {  a.Push( std::move( i ) ); }
+   a.Cancel();
+   b.Wait();
+   EXPECT_EQ( 5050, sum.load() );
+}
@@ -0,0 +1,145 @@
+#include "../include/PersistentQueue.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <future>
+#include <stdexcept>
+
+#include <dirent.h>
+#include <unistd.h>
+
+namespace
+{
+   /** Empty directory removed again at the end of the test */
+   struct TemporaryDirectory
+   {
+      TemporaryDirectory() : m_path()
+      {
+         char path[] = "/tmp/PersistentQueueTest-XXXXXX";
+         m_path = mkdtemp( path );
+      }
+
+      ~TemporaryDirectory()
+      {
+         if ( auto directory = opendir( m_path.c_str() ) )
+         {
+            while ( auto entry = readdir( directory ) )
+            {  unlink( ( m_path + "/" + entry->d_name ).c_str() ); }
+            closedir( directory );
+         }
+         rmdir( m_path.c_str() );
+      }
+
+      bool Contains( std::string const& name ) const
+      {  return access( ( m_path + "/" + name ).c_str(), F_OK ) == 0; }
+
+      std::string m_path;
+   };
+}
+
+TEST( PersistentQueue, PushPop )
+{
+   TemporaryDirectory directory;
+   PersistentQueue< int > queue( directory.m_path );
+   EXPECT_FALSE( queue.Pop() );
+   queue.Push( 23 );
+   queue.PushBatch( { 5, 7 } );
+   EXPECT_EQ( 3u, queue.Size() );
+   EXPECT_EQ( 23, queue.Pop().value() );
+
+   std::vector< int > batch;
+   EXPECT_EQ( 2u, queue.PopBatchOrWait( batch, 5, std::chrono::milliseconds( 1 ) ) );
+   EXPECT_EQ( ( std::vector< int >{ 5, 7 } ), batch );
+   EXPECT_FALSE( queue.PopOrWait( std::chrono::milliseconds( 1 ) ) );
+
+   queue.Cancel();
+   EXPECT_THROW( queue.Push( 1 ), std::logic_error );
+}
+
+TEST( PersistentQueue, ResumesAfterRestart )
+{
+   TemporaryDirectory directory;
+   {
+      PersistentQueue< int > queue( directory.m_path, 4 );
+      for ( int i( 0 ); i < 10; ++i )
+      {  queue.Push( std::move( i ) ); }
+      for ( int i( 0 ); i < 5; ++i )
+      {  EXPECT_EQ( i, queue.Pop().value() ); }
+   }
+   EXPECT_FALSE( directory.Contains( "segment-0" ) ); ///< Consumed completely
+   EXPECT_TRUE( directory.Contains( "segment-1" ) );
+
+   PersistentQueue< int > queue( directory.m_path, 4 );
+   EXPECT_EQ( 5u, queue.Size() );
+   queue.Push( 10 );
+   for ( int i( 5 ); i < 11; ++i )
+   {  EXPECT_EQ( i, queue.Pop().value() ); }
+   EXPECT_FALSE( queue.Pop() );
+}
+
+TEST( PersistentQueue, ResumesAtSegmentEnd )
+{
+   TemporaryDirectory directory;
+   {
+      PersistentQueue< int > queue( directory.m_path, 4 );
+      for ( int i( 0 ); i < 8; ++i )
+      {  queue.Push( std::move( i ) ); }
+   }
+   PersistentQueue< int > queue( directory.m_path, 4 );
+   EXPECT_EQ( 8u, queue.Size() );
+   queue.Push( 8 );
+   for ( int i( 0 ); i < 9; ++i )
+   {  EXPECT_EQ( i, queue.Pop().value() ); }
+}
+
+TEST( PersistentQueue, DifferentLayout )
+{
+   TemporaryDirectory directory;
+   {  PersistentQueue< int > queue( directory.m_path, 4 ); }
+   EXPECT_THROW( PersistentQueue< int >( directory.m_path, 8 ), std::invalid_argument );
+   EXPECT_THROW( PersistentQueue< double >( directory.m_path, 4 ), std::invalid_argument );
+}
+
+TEST( PersistentQueue, ProducerConsumer )
+{
+   TemporaryDirectory directory;
+   PersistentQueue< int > queue( directory.m_path, 1000, 100 );
+   auto producer( std::async( std::launch::async, [ &queue ]
+   {
+      for ( int i( 0 ); i < 10000; ++i )
+      {  queue.Push( std::move( i ) ); }
+   } ) );
+   for ( int i( 0 ); i < 10000; ++i )
+   {  EXPECT_EQ( i, queue.PopOrWait().value() ); }
+   producer.get();
+}
+
+TEST( PersistentQueue, ProducersFlushConcurrently )
+{
+   TemporaryDirectory directory;
+   {
+      PersistentQueue< int > queue( directory.m_path, 64, 1 );
+      std::vector< std::future< void > > producers;
+      for ( int p( 0 ); p < 4; ++p )
+      {
+         producers.emplace_back( std::async( std::launch::async, [ &queue, p ]
+         {
+            for ( int i( 0 ); i < 500; ++i )
+            {  queue.Push( p * 500 + i ); }
+         } ) );
+      }
+      for ( auto& producer : producers )
+      {  producer.get(); }
+      queue.Sync();
+   }
+   PersistentQueue< int > queue( directory.m_path, 64, 1 );
+   EXPECT_EQ( 2000u, queue.Size() );
+   std::vector< int > items;
+   while ( queue.PopBatch( items, 100 ) ) {}
+   std::sort( items.begin(), items.end() );
+   for ( int i( 0 ); i < 2000; ++i )
+   {  EXPECT_EQ( i, items[ i ] ); }
+}
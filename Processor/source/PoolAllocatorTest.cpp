@@ -0,0 +1,66 @@
+
+#include "../include/PoolAllocator.h"
+#include "../include/Processor.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <future>
+#include <thread>
+
+TEST( Pool, ReusesFreedBlock )
+{
+   PoolAllocator< int > allocator;
+   auto a( allocator.allocate( 3 ) );
+   allocator.deallocate( a, 3 );
+   auto b( allocator.allocate( 4 ) ); ///< Same size class
+   EXPECT_EQ( a, b );
+   allocator.deallocate( b, 4 );
+}
+
+TEST( Pool, Oversized )
+{
+   auto const before( Pool::Statistics().m_oversized );
+   PoolAllocator< char > allocator;
+   auto p( allocator.allocate( Pool::MaximumBlockSize + 1 ) );
+   allocator.deallocate( p, Pool::MaximumBlockSize + 1 );
+   EXPECT_EQ( before + 1, Pool::Statistics().m_oversized );
+}
+
+TEST( Pool, FreedByOtherThread )
+{
+   PoolAllocator< double > allocator;
+   std::vector< double* > blocks;
+   for ( size_t i( 0 ); i < 4 * Pool::BatchSize; ++i )
+   {  blocks.emplace_back( allocator.allocate( 1 ) ); }
+   
+   auto const before( Pool::Statistics() );
+   std::async( std::launch::async, [ &blocks, &allocator ]
+   {
+      for ( auto block : blocks ) { allocator.deallocate( block, 1 ); }
+   } ).get(); ///< The thread releases its blocks to the depot on exit at the latest
+   
+   for ( size_t i( 0 ); i < 4 * Pool::BatchSize; ++i )
+   {  blocks[ i ] = allocator.allocate( 1 ); }
+   auto const after( Pool::Statistics() );
+   EXPECT_EQ( before.m_chunks, after.m_chunks ); ///< All blocks came back via the depot
+   EXPECT_LT( before.m_releases, after.m_releases );
+   for ( auto block : blocks ) { allocator.deallocate( block, 1 ); }
+}
+
+TEST( Pool, SteadyStateWithoutHeap )
+{
+   DataProcessor< int, int > processor( 1, []( int i ) { return i * 2; } );
+   auto const run( [ &processor ]( int count )
+   {
+      for ( int i( 0 ); i < count; ++i )
+      {
+         processor.Push( std::move( i ) );
+         EXPECT_EQ( i * 2, processor.PopOrWait()->get() );
+      }
+   } );
+   run( 1000 ); ///< Warm up
+   auto const chunks( Pool::Statistics().m_chunks );
+   run( 10000 );
+   EXPECT_EQ( chunks, Pool::Statistics().m_chunks );
+}
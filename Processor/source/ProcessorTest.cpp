@@ -4,10 +4,13 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <array>
 #include <list>
+#include <numeric>
 #include <vector>
 #include <algorithm>
 #include <chrono>
+#include <thread>
 
 /** \todo Add builder to create complex processor setup
     \todo Add chain of responsibility
@@ -115,6 +118,53 @@ TEST( Queue, CancelStopsPush )
    EXPECT_FALSE( queue.Pop() );   
 }
 
+TEST( Queue, PushPopBatch )
+{
+   Queue< int > queue;
+   queue.PushBatch( std::vector< int >{ 23, 5, 7 } );
+   queue.Push( 42 );
+   std::vector< int > batch;
+   EXPECT_EQ( 2, queue.PopBatch( batch, 2 ) );
+   EXPECT_EQ( 2, queue.PopBatchOrWait( batch, 5 ) );
+   EXPECT_EQ( ( std::vector< int >{ 23, 5, 7, 42 } ), batch );
+   EXPECT_EQ( 0, queue.PopBatch( batch, 2 ) );
+   EXPECT_EQ( 0, queue.PopBatchOrWait( batch, 2, std::chrono::milliseconds( 1 ) ) );
+   queue.Cancel();
+   EXPECT_THROW( queue.PushBatch( std::vector< int >{ 1 } ), std::logic_error );
+}
+
+TEST( Queue, PushWhileLocked )
+{
+   Queue< int > queue;
+   std::vector< int > order;
+   queue.Push( 23, [ &order ]{ order.emplace_back( 23 ); } );
+   EXPECT_THROW( queue.Push( 5, []{ throw std::runtime_error( "" ); } ), std::runtime_error );
+   queue.PushBatch( std::vector< int >{ 7, 42 }, [ &order ]{ order.emplace_back( 7 ); } );
+   queue.Cancel();
+   EXPECT_THROW( queue.Push( 1, [ &order ]{ order.emplace_back( 1 ); } ), std::logic_error );
+   EXPECT_EQ( ( std::vector< int >{ 23, 7 } ), order );
+   EXPECT_EQ( 23, queue.Pop().value() );
+   EXPECT_EQ(  7, queue.Pop().value() ); ///< 5 was not pushed
+   EXPECT_EQ( 42, queue.Pop().value() );
+   EXPECT_FALSE( queue.Pop() );
+}
+
+TEST( Queue, SharedMutex )
+{
+   Queue< int > output;
+   Queue< int > input( &output.Mutex() );
+   EXPECT_EQ( &output.Mutex(), &input.Mutex() );
+   input.Push( 23, [ &output ]{ output.PushLocked( 5 ); } ); ///< Would deadlock with a mutex of each queue taken twice
+   input.PushBatch( std::vector< int >{ 7, 42 }, [ &output ]{ output.PushBatchLocked( std::vector< int >{ 1, 2 } ); } );
+   output.Cancel();
+   EXPECT_THROW( input.Push( 3, [ &output ]{ output.PushLocked( 3 ); } ), std::logic_error );
+   EXPECT_EQ( 3u, input.Size() ); ///< 3 was not pushed
+   EXPECT_EQ( 5, output.Pop().value() );
+   EXPECT_EQ( 1, output.Pop().value() );
+   EXPECT_EQ( 2, output.Pop().value() );
+   EXPECT_FALSE( output.Pop() );
+}
+
 TEST( Queue, Uncopyable )
 {
    Queue< Uncopyable > queue;
@@ -127,6 +177,105 @@ TEST( Queue, Uncopyable )
    EXPECT_FALSE( queue.Pop() );   
 }
 
+template < typename QueueT >
+struct SingleConsumerQueueTest : testing::Test {};
+
+typedef testing::Types< SpscQueue< int >, MpscQueue< int > > SingleConsumerQueueTypes;
+TYPED_TEST_CASE( SingleConsumerQueueTest, SingleConsumerQueueTypes );
+
+TYPED_TEST( SingleConsumerQueueTest, PushPop )
+{
+   TypeParam queue;
+   EXPECT_FALSE( queue.Pop() );
+   queue.Push( 23 );
+   queue.PushBatch( std::vector< int >{ 5, 7, 42 } );
+   EXPECT_EQ( 4, queue.Size() );
+   EXPECT_EQ( 23, queue.Pop() );
+   EXPECT_EQ(  5, queue.PopOrWait() );
+   std::vector< int > batch;
+   EXPECT_EQ( 2, queue.PopBatchOrWait( batch, 5 ) );
+   EXPECT_EQ( ( std::vector< int >{ 7, 42 } ), batch );
+   EXPECT_EQ( 0, queue.Size() );
+   EXPECT_FALSE( queue.PopOrWait( std::chrono::milliseconds( 1 ) ) );
+}
+
+TYPED_TEST( SingleConsumerQueueTest, CancelStopsPush )
+{
+   TypeParam queue;
+   queue.Push( 23 );
+   queue.Push(  5 );
+   queue.Cancel();
+   EXPECT_TRUE( queue.IsCanceled() );
+   EXPECT_THROW( queue.Push( 7 ), std::logic_error );
+   EXPECT_THROW( queue.PushBatch( std::vector< int >{ 7 } ), std::logic_error );
+   EXPECT_EQ( 23, queue.Pop().value() );
+   EXPECT_EQ(  5, queue.Pop().value() );
+   EXPECT_FALSE( queue.Pop() );   
+}
+
+TYPED_TEST( SingleConsumerQueueTest, CancelBreaksWait )
+{
+   auto const start( std::chrono::steady_clock::now() );
+   TypeParam queue;
+   auto result( std::async( std::launch::async, [&]
+   {  return queue.PopOrWait( std::chrono::seconds( 5 ) ); } ) );
+   queue.Cancel();
+   EXPECT_FALSE( result.get() );
+   EXPECT_TRUE( std::chrono::steady_clock::now() - start < std::chrono::seconds( 5 ) );
+}
+
+TYPED_TEST( SingleConsumerQueueTest, ProducerConsumer )
+{
+   TypeParam queue;
+   auto producer( std::async( std::launch::async, [ &queue ]
+   {
+      for ( int i( 0 ); i < 10000; ++i )
+      {  queue.Push( std::move( i ) ); }
+   } ) );
+   for ( int i( 0 ); i < 10000; ++i )
+   {
+      auto item( queue.PopOrWait( std::chrono::seconds( 5 ) ) );
+      ASSERT_TRUE( (bool)item );
+      EXPECT_EQ( i, item.value() );
+   }
+   producer.get();
+   EXPECT_FALSE( queue.Pop() );
+}
+
+TEST( SpscQueue, Uncopyable )
+{
+   SpscQueue< Uncopyable > queue;
+   queue.Push( Uncopyable(23) );
+   queue.Push( Uncopyable( 5) );
+   EXPECT_EQ( 23, queue.Pop().value().m_value );
+   queue.Push( Uncopyable( 7) ); ///< Reuses the node of 23
+   EXPECT_EQ(  5, queue.PopOrWait().value().m_value );
+   EXPECT_EQ(  7, queue.PopOrWait().value().m_value );
+   EXPECT_FALSE( queue.Pop() );   
+}
+
+TEST( MpscQueue, MultipleProducers )
+{
+   MpscQueue< int > queue;
+   std::vector< std::future< void > > producers;
+   for ( int p( 0 ); p < 4; ++p )
+   {
+      producers.emplace_back( std::async( std::launch::async, [ &queue, p ]
+      {
+         for ( int i( 0 ); i < 1000; ++i )
+         {  queue.Push( p * 1000 + i ); }
+      } ) );
+   }
+   std::array< int, 4 > next{ { 0, 0, 0, 0 } };
+   for ( int i( 0 ); i < 4000; ++i )
+   {
+      auto const item( queue.PopOrWait( std::chrono::seconds( 5 ) ).value() );
+      EXPECT_EQ( next[ item / 1000 ]++, item % 1000 ); ///< Ordered per producer
+   }
+   for ( auto& producer : producers ) { producer.get(); }
+   EXPECT_FALSE( queue.Pop() );
+}
+
 TEST( BufferingTaskProcessor, ConstructDestroy )
 {
    BufferingTaskProcessor< int > processor( 2 );
@@ -173,6 +322,81 @@ TEST( BufferingTaskProcessor, CancelStopsPush )
    EXPECT_FALSE( processor.Pop() );
 }
 
+TEST( BufferingTaskProcessor, CancelDiscardsEnqueued )
+{
+   std::promise< void > started;
+   BufferingTaskProcessor< int > processor( 1 );
+   processor.Push( [ &started ]( CancellationToken const& token )
+   {
+      started.set_value();
+      while ( !token.IsCanceled() ) { std::this_thread::yield(); }
+      return 23;
+   } );
+   processor.Push( []{ return 5; } );
+   processor.Push( []{ return 7; } );
+   started.get_future().wait();
+   processor.Cancel( CancelMode::Discard );
+   EXPECT_EQ( 23, processor.Pop()->get() );
+   EXPECT_THROW( processor.Pop()->get(), OperationCanceled );
+   EXPECT_THROW( processor.Pop()->get(), OperationCanceled );
+   EXPECT_FALSE( processor.Pop() );
+}
+
+TEST( BufferingTaskProcessor, PushBatch )
+{
+   BufferingTaskProcessor< int > processor( 2, 4 );
+   std::vector< std::function< int() > > tasks;
+   for ( int i( 0 ); i < 10; ++i )
+   {  tasks.emplace_back( [ i ]{ return i; } ); }
+   processor.PushBatch( std::move( tasks ) );
+   for ( int i( 0 ); i < 10; ++i )
+   {  EXPECT_EQ( i, processor.PopOrWait()->get() ); }
+   EXPECT_FALSE( processor.Pop() );
+}
+
+TEST( BufferingTaskProcessor, ConcurrentPushKeepsOrder )
+{
+   BufferingTaskProcessor< std::pair< int, int > > processor( 2 );
+   std::vector< std::future< void > > producers;
+   for ( int p( 0 ); p < 4; ++p )
+   {
+      producers.emplace_back( std::async( std::launch::async, [ &processor, p ]
+      {
+         for ( int i( 0 ); i < 250; ++i )
+         {  processor.Push( [ p, i ]{ return std::make_pair( p, i ); } ); }
+      } ) );
+   }
+   for ( auto& producer : producers ) { producer.get(); }
+   std::array< int, 4 > next{ { 0, 0, 0, 0 } };
+   for ( int i( 0 ); i < 1000; ++i )
+   {
+      auto const result( processor.PopOrWait()->get() );
+      EXPECT_EQ( next[ result.first ]++, result.second ); ///< Results of a producer are in order of its pushes
+   }
+   EXPECT_FALSE( processor.Pop() );
+}
+
+TEST( BufferingTaskProcessor, ConcurrentPushOutputOrderIsInputOrder )
+{
+   std::vector< std::pair< int, int > > executed; ///< Order of the input queue, since a single worker takes the tasks
+   BufferingTaskProcessor< std::pair< int, int > > processor( 1 );
+   std::vector< std::future< void > > producers;
+   for ( int p( 0 ); p < 4; ++p )
+   {
+      producers.emplace_back( std::async( std::launch::async, [ &processor, &executed, p ]
+      {
+         for ( int i( 0 ); i < 250; ++i )
+         {  processor.Push( [ &executed, p, i ]{ executed.emplace_back( p, i ); return executed.back(); } ); }
+      } ) );
+   }
+   for ( auto& producer : producers ) { producer.get(); }
+   std::vector< std::pair< int, int > > results;
+   for ( int i( 0 ); i < 1000; ++i )
+   {  results.emplace_back( processor.PopOrWait()->get() ); }
+   EXPECT_EQ( executed, results );
+   EXPECT_FALSE( processor.Pop() );
+}
+
 TEST( BufferingTaskProcessor, TerminatingVoid )
 {
    std::atomic< int > exception( 0 ), called( 0 );
@@ -192,6 +416,37 @@ TEST( BufferingTaskProcessor, TerminatingVoid )
    EXPECT_EQ( 1, exception.load() );
 }
 
+TEST( BufferingTaskProcessor, ElasticScaling )
+{
+   std::promise< void > release;
+   std::shared_future< void > released( release.get_future() );
+   BufferingTaskProcessor< int > processor( ElasticWorkerPolicy{ 1, 4, 2, std::chrono::seconds( 10 ), std::chrono::milliseconds( 20 ) } );
+   EXPECT_EQ( 1, processor.ScalingStatistics().m_current );
+   for ( int i( 0 ); i < 8; ++i )
+   {  processor.Push( [ released, i ]{ released.wait(); return i; } ); }
+   EXPECT_EQ( 4, processor.ScalingStatistics().m_peak );
+   release.set_value();
+   for ( int i( 0 ); i < 8; ++i )
+   {  EXPECT_EQ( i, processor.PopOrWait()->get() ); }
+   
+   auto const deadline( std::chrono::steady_clock::now() + std::chrono::seconds( 5 ) );
+   while ( processor.ScalingStatistics().m_current > 1 && std::chrono::steady_clock::now() < deadline )
+   {  std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) ); }
+   auto const statistics( processor.ScalingStatistics() );
+   EXPECT_EQ( 1, statistics.m_current );
+   EXPECT_EQ( 4, statistics.m_started );
+   EXPECT_EQ( 3, statistics.m_retired );
+   
+   processor.Cancel();
+   EXPECT_TRUE( processor.WaitFor( std::chrono::seconds( 5 ) ) );
+}
+
+TEST( BufferingTaskProcessor, ElasticInvalidPolicy )
+{
+   EXPECT_THROW( BufferingTaskProcessor<> processor( ElasticWorkerPolicy{ 0, 4, 2, std::chrono::seconds( 1 ), std::chrono::seconds( 1 ) } ), std::invalid_argument );
+   EXPECT_THROW( BufferingTaskProcessor<> processor( ElasticWorkerPolicy{ 3, 2, 2, std::chrono::seconds( 1 ), std::chrono::seconds( 1 ) } ), std::invalid_argument );
+}
+
 TEST( TaskProcessor, ConstructDestroy )
 {
    TaskProcessor< int > processor( 2 );
@@ -253,6 +508,47 @@ TEST( TaskProcessor, CancelStopsPush )
    EXPECT_EQ( 23, futureA.get() );
 }
 
+TEST( TaskProcessor, CancellationToken )
+{
+   std::promise< void > started;
+   TaskProcessor< int > processor( 1 );
+   auto future( processor.Push( [ &started ]( CancellationToken const& token )
+   {
+      started.set_value();
+      int iterations( 0 );
+      for ( ; !token.IsCanceled(); ++iterations ) { std::this_thread::yield(); }
+      return iterations;
+   } ) );
+   started.get_future().wait();
+   EXPECT_FALSE( processor.GetToken().IsCanceled() );
+   processor.Cancel( CancelMode::Discard );
+   EXPECT_TRUE( processor.GetToken().IsCanceled() );
+   EXPECT_LE( 0, future.get() );
+}
+
+TEST( TaskProcessor, CancelDiscardsEnqueued )
+{
+   std::promise< void > started;
+   std::atomic< int > called( 0 );
+   TaskProcessor< int > processor( 1 );
+   auto futureA( processor.Push( [ &started ]( CancellationToken const& token )
+   {
+      started.set_value();
+      while ( !token.IsCanceled() ) { std::this_thread::yield(); }
+      token.ThrowIfCanceled();
+      return 23;
+   } ) );
+   auto futureB( processor.Push( [ &called ]{ return ++called; } ) );
+   auto futureC( processor.Push( [ &called ]{ return ++called; } ) );
+   started.get_future().wait();
+   processor.Cancel( CancelMode::Discard );
+   EXPECT_THROW( processor.Push( []{ return 7; } ), std::logic_error );
+   EXPECT_THROW( futureA.get(), OperationCanceled );
+   EXPECT_THROW( futureB.get(), OperationCanceled );
+   EXPECT_THROW( futureC.get(), OperationCanceled );
+   EXPECT_EQ( 0, called.load() );
+}
+
 TEST( TaskProcessor, Void )
 {
    TaskProcessor<> processor( 4 );
@@ -376,6 +672,40 @@ TEST( DataProcessor, VoidOutput )
    EXPECT_EQ( 28, sum.load() );
 }
 
+TEST( DataProcessor, Elastic )
+{
+   DataProcessor< int, int > processor( ElasticWorkerPolicy{ 1, 2, 1, std::chrono::milliseconds( 1 ), std::chrono::milliseconds( 50 ) }, []( int i ) 
+   { 
+      std::this_thread::sleep_for( std::chrono::milliseconds( 2 ) );
+      return i * 2; 
+   } );
+   for ( int i( 0 ); i < 10; ++i )
+   {  processor.Push( std::move( i ) ); }
+   for ( int i( 0 ); i < 10; ++i )
+   {  EXPECT_EQ( i * 2, processor.PopOrWait()->get() ); }
+   EXPECT_EQ( 2, processor.ScalingStatistics().m_peak );
+}
+
+TEST( DataProcessor, CancelableFunction )
+{
+   std::promise< void > started;
+   DataProcessor< int, int > processor( 1, [ &started ]( int i, CancellationToken const& token ) 
+   { 
+      if ( i == 23 )
+      {
+         started.set_value();
+         while ( !token.IsCanceled() ) { std::this_thread::yield(); }
+      }
+      return i * 2; 
+   } );
+   processor.Push( 23 );
+   processor.Push(  5 );
+   started.get_future().wait();
+   processor.Cancel( CancelMode::Discard );
+   EXPECT_EQ( 46, processor.PopOrWait()->get() );
+   EXPECT_THROW( processor.PopOrWait()->get(), OperationCanceled );
+}
+
 TEST( DataProcessor, Uncopyable )
 {
    DataProcessor< Uncopyable, Uncopyable > processor( 1, []( Uncopyable i ) 
@@ -482,6 +812,70 @@ TEST( ContinuationDataProcessor, Throw )
    b.Wait();   ///< Wait for last
 }
 
+TEST( ContinuationDataProcessor, CancelDiscardsEnqueued )
+{
+   std::promise< void > started;
+   std::atomic< int > called( 0 );
+   DataProcessor< int, int > a( 1, []( int i ) { return i; } );
+   ContinuationDataProcessor< int, int > b( 1, a, [ &started, &called ]( std::future< int > i, CancellationToken const& token )
+   {
+      if ( ++called == 1 )
+      {
+         started.set_value();
+         while ( !token.IsCanceled() ) { std::this_thread::yield(); }
+      }
+      return i.get();
+   } );
+   a.Push( 3 );
+   a.Push( 5 );
+   started.get_future().wait();
+   b.Cancel( CancelMode::Discard );
+   b.Wait();
+   EXPECT_EQ( 3, b.PopOrWait()->get() );
+   while ( auto item = b.Pop() )
+   {  EXPECT_THROW( item->get(), OperationCanceled ); }
+   EXPECT_EQ( 1, called.load() );
+   a.Cancel();
+}
+
+TEST( ContinuationDataProcessor, BatchedHandoff )
+{
+   DataProcessor< int, int > a( 2, []( int i ){ return i + 1; }, 8 );
+   ContinuationDataProcessor< int, int > b( 2, a, []( std::future< int > i ){ return i.get() * 2; }, 8 );
+   std::vector< int > input( 500 );
+   std::iota( input.begin(), input.end(), 0 );
+   a.PushBatch( std::move( input ) );
+   a.Cancel();
+   b.Wait();
+   for ( int i( 0 ); i < 500; ++i )
+   {  EXPECT_EQ( ( i + 1 ) * 2, b.Pop()->get() ); }
+   EXPECT_FALSE( b.Pop() );
+}
+
+TEST( ContinuationDataProcessor, SpscLink )
+{
+   DataProcessor< int, int, SpscLink > a( 2, []( int i ){ return i + 1; } );
+   ContinuationDataProcessor< int, int, SpscLink > b( 2, a, []( std::future< int > i ){ return i.get() * 2; } );
+   std::vector< int > results;
+   TerminationProcessor< int > c( b, [ &results ]( std::future< int > i ){ results.emplace_back( i.get() ); } );
+   for ( int i( 0 ); i < 500; ++i )
+   {  a.Push( std::move( i ) ); }
+   a.Cancel();
+   c.Wait();
+   ASSERT_EQ( 500u, results.size() );
+   for ( int i( 0 ); i < 500; ++i )
+   {  EXPECT_EQ( ( i + 1 ) * 2, results[ i ] ); }
+}
+
+TEST( ContinuationDataProcessor, LinkConcurrency )
+{
+   static_assert( QueueConcurrency< LinkQueue< MpmcLink, int >::type >::MultipleConsumers, "Any number of threads" );
+   static_assert( QueueConcurrency< LinkQueue< MpscLink, int >::type >::MultipleProducers, "Several producers" );
+   static_assert( !QueueConcurrency< LinkQueue< MpscLink, int >::type >::MultipleConsumers, "Single consumer" );
+   static_assert( !QueueConcurrency< LinkQueue< SpscLink, int >::type >::MultipleProducers, "Single producer" );
+   static_assert( !QueueConcurrency< LinkQueue< SpscLink, int >::type >::MultipleConsumers, "Single consumer" );
+}
+
 TEST( ContinuationDataProcessor, ComplexChaining )
 {
    DataProcessor< std::list< int >, std::vector< int > > a( 2, []( std::list< int > input )
@@ -0,0 +1,126 @@
+
+#include "../include/ReductionProcessor.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+TEST( ReductionProcessor, ConstructDestroy )
+{
+   DataProcessor< int, int > a( 1, []( int i ) { return i; } );
+   ReductionProcessor< int, int > b( 2, a, 0, []( int& sum, int i ) { sum += i; }, []( int& sum, int other ) { sum += other; } );
+}
+
+TEST( ReductionProcessor, SingleConsumerLink )
+{
+   DataProcessor< int, int, MpscLink > a( 1, []( int i ) { return i; } );
+   EXPECT_THROW( ( ReductionProcessor< int, int >( 2, a, 0, []( int& sum, int i ) { sum += i; }, []( int& sum, int other ) { sum += other; } ) ), std::invalid_argument );
+   ReductionProcessor< int, int > b( 1, a, 0, []( int& sum, int i ) { sum += i; }, []( int& sum, int other ) { sum += other; } );
+   a.Push( 23 );
+   a.Cancel();
+   b.Wait();
+   EXPECT_EQ( 23, b.Flush() );
+}
+
+TEST( ReductionProcessor, Sum )
+{
+   DataProcessor< int, long long > a( 2, []( int i ) { return static_cast< long long >( i ); } );
+   ReductionProcessor< long long, long long > b( 4, a, 0, []( long long& sum, long long i ) { sum += i; }, []( long long& sum, long long other ) { sum += other; } );
+   for ( int no( 1 ); no <= 1000; ++no ) { a.Push( int( no ) ); }
+   a.Cancel(); ///< Cancel first
+   b.Wait();   ///< Wait for last
+   EXPECT_EQ( 1000ll * 1001 / 2, b.Flush() );
+   EXPECT_EQ( 0ll, b.Flush() );
+   EXPECT_EQ( 0u, b.FailedCount() );
+}
+
+TEST( ReductionProcessor, FlushWhileRunning )
+{
+   DataProcessor< int, int > a( 2, []( int i ) { return i; } );
+   ReductionProcessor< int, int > b( 2, a, 0, []( int& sum, int i ) { sum += i; }, []( int& sum, int other ) { sum += other; } );
+   int flushed( 0 );
+   for ( int no( 1 ); no <= 100; ++no )
+   {
+      a.Push( int( no ) );
+      if ( no % 10 == 0 ) { flushed += b.Flush(); }
+   }
+   a.Cancel();
+   b.Wait();
+   flushed += b.Flush();
+   EXPECT_EQ( 5050, flushed );
+}
+
+TEST( ReductionProcessor, Throw )
+{
+   DataProcessor< int, int > a( 2, []( int i )
+   {
+      if ( i == 5 )
+      {  throw std::exception(); }
+      return i;
+   } );
+   ReductionProcessor< int, std::vector< int > > b( 2, a, std::vector< int >()
+      ,[]( std::vector< int >& values, int i ) { values.emplace_back( i ); }
+      ,[]( std::vector< int >& values, std::vector< int >&& other ) { values.insert( values.end(), other.begin(), other.end() ); } );
+   for ( auto i : { 23, 5, 7, 5, 42 } ) { a.Push( std::move( i ) ); }
+   a.Cancel();
+   b.Wait();
+   auto values( b.Flush() );
+   std::sort( values.begin(), values.end() );
+   EXPECT_EQ( std::vector< int >( { 7, 23, 42 } ), values );
+   EXPECT_EQ( 2u, b.FailedCount() );
+}
+
+TEST( ReductionProcessor, AccumulateThrows )
+{
+   DataProcessor< int, int > a( 1, []( int i ) { return i; } );
+   ReductionProcessor< int, int > b( 1, a, 0
+      ,[]( int& sum, int i ) 
+      {  
+         if ( i == 5 )
+         {  throw std::runtime_error( "Accumulate failed" ); }
+         sum += i; 
+      }
+      ,[]( int& sum, int other ) { sum += other; } );
+   for ( auto i : { 23, 5 } ) { a.Push( std::move( i ) ); }
+   a.Cancel();
+   EXPECT_THROW( b.Wait(), std::runtime_error ); ///< Not counted as failed input
+   EXPECT_EQ( 23, b.Flush() );
+   EXPECT_EQ( 0u, b.FailedCount() );
+}
+
+TEST( KeyedReductionProcessor, WordCount )
+{
+   BufferingTaskProcessor< std::string > a( 2 );
+   KeyedReductionProcessor< std::string, std::string, int > b( 4, a
+      ,[]( std::string const& word ) { return word; }
+      ,[]( int& count, std::string ) { ++count; }
+      ,[]( int& count, int other ) { count += other; } );
+   for ( int no( 0 ); no < 300; ++no )
+   {
+      a.Push( [ no ]{ return std::string( no % 3 == 0 ? "a" : "b" ); } );
+   }
+   a.Cancel();
+   b.Wait();
+   auto const counts( b.Flush() );
+   EXPECT_EQ( 2u, counts.size() );
+   EXPECT_EQ( 100, counts.at( "a" ) );
+   EXPECT_EQ( 200, counts.at( "b" ) );
+}
+
+TEST( KeyedReductionProcessor, Sum )
+{
+   DataProcessor< int, int > a( 2, []( int i ) { return i; } );
+   KeyedReductionProcessor< int, bool, long > b( 3, a
+      ,[]( int const& i ) { return i % 2 == 0; }
+      ,[]( long& sum, int i ) { sum += i; }
+      ,[]( long& sum, long other ) { sum += other; } );
+   for ( int no( 1 ); no <= 100; ++no ) { a.Push( int( no ) ); }
+   a.Cancel();
+   b.Wait();
+   auto const sums( b.Flush() );
+   EXPECT_EQ( 2550, sums.at( true ) );
+   EXPECT_EQ( 2500, sums.at( false ) );
+}
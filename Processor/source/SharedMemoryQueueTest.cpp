@@ -0,0 +1,191 @@
+#include "../include/SharedMemoryQueue.h"
+#include "../include/Processor.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+namespace
+{
+   struct Sample
+   {
+      int m_id;
+      double m_value;
+   };
+
+   std::string UniqueName( std::string const& test )
+   {  return "/cpp-fun-" + test + "-" + std::to_string( getpid() ); }
+}
+
+TEST( SharedMemoryQueue, PushPop )
+{
+   SharedMemoryQueue< Sample > queue( UniqueName( "PushPop" ), 3 );
+   EXPECT_EQ( 4u, queue.Capacity() );
+   EXPECT_FALSE( queue.Pop() );
+   queue.Push( Sample{ 1, 1.5 } );
+   queue.Push( Sample{ 2, 2.5 } );
+   EXPECT_EQ( 2u, queue.Size() );
+   EXPECT_EQ( 1, queue.Pop()->m_id );
+   EXPECT_EQ( 2.5, queue.Pop()->m_value );
+   EXPECT_FALSE( queue.PopOrWait( std::chrono::milliseconds( 1 ) ) );
+}
+
+TEST( SharedMemoryQueue, Full )
+{
+   SharedMemoryQueue< int > queue( UniqueName( "Full" ), 2 );
+   EXPECT_TRUE( queue.TryPush( 1 ) );
+   EXPECT_TRUE( queue.TryPush( 2 ) );
+   EXPECT_FALSE( queue.TryPush( 3 ) );
+   EXPECT_EQ( 1, queue.Pop().value() );
+   EXPECT_TRUE( queue.TryPush( 3 ) );
+
+   std::vector< int > batch;
+   EXPECT_EQ( 2u, queue.PopBatch( batch, 5 ) );
+   EXPECT_EQ( ( std::vector< int >{ 2, 3 } ), batch );
+}
+
+TEST( SharedMemoryQueue, OpenByName )
+{
+   auto const name( UniqueName( "OpenByName" ) );
+   EXPECT_THROW( SharedMemoryQueue< int >{ name }, std::system_error );
+
+   SharedMemoryQueue< int > a( name, 16 );
+   EXPECT_THROW( ( SharedMemoryQueue< int >( name, 16 ) ), std::system_error );
+   EXPECT_THROW( SharedMemoryQueue< double >{ name }, std::invalid_argument );
+
+   SharedMemoryQueue< int > b( name );
+   EXPECT_EQ( 16u, b.Capacity() );
+   a.Push( 23 );
+   EXPECT_EQ( 23, b.Pop().value() );
+}
+
+TEST( SharedMemoryQueue, OpenWhileCreating )
+{
+   auto const name( UniqueName( "OpenWhileCreating" ) );
+   auto opener( std::async( std::launch::async, [ &name ]
+   {
+      while ( 1 )
+      {
+         try 
+         {  return SharedMemoryQueue< int >( name ).Capacity(); }
+         catch ( std::system_error const& ) ///< Not created yet
+         {  std::this_thread::yield(); }
+      }
+   } ) );
+   SharedMemoryQueue< int > queue( name, 16 );
+   EXPECT_EQ( 16u, opener.get() ); ///< Waits for size and initialization instead of throwing invalid_argument
+}
+
+TEST( SharedMemoryQueue, OpenNotSized )
+{
+   auto const name( UniqueName( "OpenNotSized" ) );
+   auto const fd( shm_open( name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600 ) );
+   ASSERT_NE( -1, fd );
+   EXPECT_THROW( SharedMemoryQueue< int >{ name }, std::invalid_argument );
+   close( fd );
+   shm_unlink( name.c_str() );
+}
+
+TEST( SharedMemoryQueue, PopBatchOfNone )
+{
+   SharedMemoryQueue< int > queue( UniqueName( "PopBatchOfNone" ), 4 );
+   queue.Push( 1 );
+   std::vector< int > batch;
+   EXPECT_EQ( 0u, queue.PopBatchOrWait( batch, 0 ) );
+   EXPECT_TRUE( batch.empty() );
+   EXPECT_EQ( 1u, queue.Size() );
+}
+
+TEST( SharedMemoryQueue, CancelBreaksWait )
+{
+   SharedMemoryQueue< int > queue( UniqueName( "CancelBreaksWait" ), 4 );
+   auto consumer( std::async( std::launch::async, [ &queue ]{ return queue.PopOrWait(); } ) );
+   std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+   queue.Cancel();
+   EXPECT_FALSE( consumer.get() );
+   EXPECT_THROW( queue.Push( 1 ), std::logic_error );
+}
+
+TEST( SharedMemoryQueue, CancelRightAfterPush )
+{
+   for ( int round( 0 ); round < 200; ++round )
+   {
+      SharedMemoryQueue< int > queue( UniqueName( "CancelRightAfterPush" ), 16 );
+      auto consumer( std::async( std::launch::async, [ &queue ]
+      {
+         int count( 0 );
+         while ( queue.PopOrWait() ) { ++count; }
+         return count;
+      } ) );
+      for ( int i( 0 ); i < 10; ++i )
+      {  queue.Push( i ); }
+      queue.Cancel();
+      EXPECT_EQ( 10, consumer.get() ); ///< The items pushed before the cancellation are not lost
+   }
+}
+
+TEST( SharedMemoryQueue, WaitWhileFull )
+{
+   SharedMemoryQueue< int > queue( UniqueName( "WaitWhileFull" ), 2 );
+   auto producer( std::async( std::launch::async, [ &queue ]
+   {
+      for ( int i( 0 ); i < 1000; ++i )
+      {  queue.Push( i ); }
+   } ) );
+   for ( int i( 0 ); i < 1000; ++i )
+   {  EXPECT_EQ( i, queue.PopOrWait().value() ); }
+   producer.get();
+}
+
+/** The child process produces with a TerminationProcessor, the
+ *  parent process consumes into a DataProcessor.
+ * */
+TEST( SharedMemoryQueue, BetweenProcesses )
+{
+   auto const name( UniqueName( "BetweenProcesses" ) );
+   SharedMemoryQueue< Sample > queue( name, 64 );
+
+   auto const child( fork() );
+   ASSERT_NE( -1, child );
+   if ( child == 0 )
+   {
+      {
+         SharedMemoryQueue< Sample > output( name );
+         BufferingTaskProcessor< Sample > a( 2 );
+         TerminationProcessor< Sample > b( a, [ &output ]( std::future< Sample > sample ){ output.Push( sample.get() ); } );
+         for ( int i( 0 ); i < 1000; ++i )
+         {  a.Push( [ i ]{ return Sample{ i, i * .5 }; } ); }
+         a.Cancel();
+         b.Wait();
+         output.Cancel();
+      }
+      _exit( 0 );
+   }
+
+   DataProcessor< Sample, double > processor( 2, []( Sample sample ){ return sample.m_value * 2; } );
+   size_t count( 0 );
+   while ( auto sample = queue.PopOrWait() )
+   {
+      processor.Push( std::move( sample.value() ) );
+      ++count;
+   }
+
+   double sum( 0 );
+   for ( size_t i( 0 ); i < count; ++i )
+   {  sum += processor.PopOrWait()->get(); }
+
+   int status( 0 );
+   waitpid( child, &status, 0 );
+   EXPECT_EQ( 0, status );
+   EXPECT_EQ( 1000u, count );
+   EXPECT_EQ( 999. * 1000. / 2., sum );
+}
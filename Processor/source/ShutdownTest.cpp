@@ -0,0 +1,144 @@
+
+#include "../include/Shutdown.h"
+#include "../include/BatchingProcessor.h"
+#include "../include/ReductionProcessor.h"
+#include "../include/PartitionedDataProcessor.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <future>
+
+TEST( Shutdown, Empty )
+{
+   auto const report( Shutdown( std::chrono::seconds( 1 ) ).Drain() );
+   EXPECT_FALSE( report.m_timedOut );
+   EXPECT_TRUE( report.m_stages.empty() );
+}
+
+TEST( Shutdown, DrainWithinDeadline )
+{
+   std::atomic< int > processed( 0 );
+   std::vector< ShutdownReport > progress;
+   std::promise< void > release;
+   auto const released( release.get_future().share() );
+   DataProcessor< int, int > a( 2, [ released ]( int i ) { if ( i == 0 ) { released.wait(); } return i; } ); ///< Blocks until progress is reported once
+   ContinuationDataProcessor< int, int > b( 2, a, []( std::future< int > i ) { return i.get() * 2; } );
+   TerminationProcessor< int > c( b, [ &processed ]( std::future< int > i ) { i.get(); ++processed; } );
+   for ( int no( 0 ); no < 100; ++no ) { a.Push( int( no ) ); }
+   
+   auto const report( Shutdown( std::chrono::seconds( 10 ), std::chrono::milliseconds( 10 ), [ &progress, &release ]( ShutdownReport const& r )
+   {  
+      if ( progress.empty() ) 
+      {  release.set_value(); }
+      progress.emplace_back( r ); 
+   } ).Drain( a, b, c ) );
+   
+   EXPECT_FALSE( report.m_timedOut );
+   EXPECT_EQ( 100, processed.load() );
+   EXPECT_EQ( 3u, report.m_stages.size() );
+   EXPECT_EQ( 0u, report.Pending() );
+   EXPECT_EQ( 0u, report.Discarded() );
+   EXPECT_TRUE( std::all_of( report.m_stages.begin(), report.m_stages.end(), []( StageProgress const& s ) { return s.m_done; } ) );
+   EXPECT_LE( 2u, progress.size() );
+   EXPECT_THROW( a.Push( 23 ), std::logic_error );
+}
+
+TEST( Shutdown, DiscardAfterDeadline )
+{
+   std::atomic< int > processed( 0 );
+   std::vector< size_t > pending;
+   DataProcessor< int, int > a( 1, []( int i, CancellationToken const& token ) ///< The first task blocks until it gets discarded
+   {
+      while ( !token.IsCanceled() )
+      {  std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) ); }
+      return i;
+   } );
+   ContinuationDataProcessor< int, int > b( 1, a, [ &processed ]( std::future< int > i ) { ++processed; return i.get(); } );
+   for ( int no( 0 ); no < 100; ++no ) { a.Push( int( no ) ); }
+   
+   auto const start( std::chrono::steady_clock::now() );
+   auto const report( Shutdown( std::chrono::milliseconds( 100 ), std::chrono::milliseconds( 10 ), [ &pending ]( ShutdownReport const& r )
+   {  pending.emplace_back( r.m_stages[ 0 ].m_pending ); } ).Drain( a, b ) );
+   
+   EXPECT_TRUE( std::chrono::seconds( 1 ) > std::chrono::steady_clock::now() - start );
+   EXPECT_TRUE( report.m_timedOut );
+   EXPECT_TRUE( report.m_stages[ 0 ].m_done );
+   EXPECT_TRUE( report.m_stages[ 1 ].m_done );
+   EXPECT_EQ( 99u, report.m_stages[ 0 ].m_discarded ); ///< All but the running one
+   EXPECT_EQ( 99u, report.m_stages[ 1 ].m_discarded ); ///< All but the one waiting for the running one
+   EXPECT_EQ( 1, processed.load() );
+   ASSERT_FALSE( pending.empty() );
+   EXPECT_TRUE( std::is_sorted( pending.begin(), pending.end() - 1, std::greater< size_t >() ) );
+}
+
+TEST( Shutdown, TaskIgnoringToken )
+{
+   std::promise< void > release;
+   auto const released( release.get_future().share() );
+   DataProcessor< int, int > a( 1, [ released ]( int i ) { released.wait(); return i; } ); ///< Does not look at any token
+   for ( int no( 0 ); no < 10; ++no ) { a.Push( int( no ) ); }
+   
+   auto const start( std::chrono::steady_clock::now() );
+   auto const report( Shutdown( std::chrono::milliseconds( 50 ), std::chrono::milliseconds( 10 ), Shutdown::progress_function_type(), std::chrono::milliseconds( 50 ) ).Drain( a ) );
+   
+   EXPECT_TRUE( std::chrono::seconds( 1 ) > std::chrono::steady_clock::now() - start );
+   EXPECT_TRUE( report.m_timedOut );
+   EXPECT_FALSE( report.m_stages[ 0 ].m_done );
+   release.set_value(); ///< Otherwise the destructor would wait forever
+   a.Wait();
+   EXPECT_EQ( 9u, a.DiscardedCount() );
+}
+
+TEST( Shutdown, DiscardCountsResultsLeftForTermination )
+{
+   std::atomic< int > processed( 0 );
+   std::promise< void > release;
+   auto const blocking( release.get_future().share() );
+   DataProcessor< int, int > a( 1, []( int i ) { return i; } );
+   TerminationProcessor< int > c( a, [ &processed, blocking ]( std::future< int > i ) { i.get(); ++processed; blocking.wait(); } ); ///< Blocks in the first result
+   for ( int no( 0 ); no < 100; ++no ) { a.Push( int( no ) ); }
+   
+   bool released( false );
+   auto const report( Shutdown( std::chrono::milliseconds( 50 ), std::chrono::milliseconds( 10 ), [ &release, &released ]( ShutdownReport const& r )
+   {  
+      if ( r.m_timedOut && !released ) 
+      {  
+         release.set_value(); 
+         released = true;
+      }
+   } ).Drain( a, c ) );
+   
+   EXPECT_TRUE( report.m_timedOut );
+   EXPECT_EQ( 1, processed.load() );
+   EXPECT_EQ( 99u, report.m_stages[ 1 ].m_discarded );
+   EXPECT_EQ( 99u, report.Discarded() );
+}
+
+TEST( Shutdown, DrainOtherStages )
+{
+   std::atomic< int > batches( 0 );
+   PartitionedDataProcessor< int, int, int > a( 2, []( int const& i ) { return i; }, []( int i ) { return i; } );
+   BatchingProcessor< int > b( a, 10, std::chrono::milliseconds( 10 ) );
+   TerminationProcessor< std::vector< int > > c( b, [ &batches ]( std::future< std::vector< int > > batch ) { batch.get(); ++batches; } );
+   DataProcessor< int, long long > d( 2, []( int i ) { return static_cast< long long >( i ); } );
+   ReductionProcessor< long long, long long > e( 2, d, 0, []( long long& sum, long long i ) { sum += i; }, []( long long& sum, long long other ) { sum += other; } );
+   for ( int no( 1 ); no <= 100; ++no ) 
+   {  
+      a.Push( int( no ) ); 
+      d.Push( int( no ) );
+   }
+   
+   auto const batching( Shutdown( std::chrono::seconds( 10 ) ).Drain( a, b, c ) );
+   auto const reduction( Shutdown( std::chrono::seconds( 10 ) ).Drain( d, e ) );
+   
+   EXPECT_FALSE( batching.m_timedOut );
+   EXPECT_EQ( 0u, batching.Pending() );
+   EXPECT_EQ( 0u, batching.Discarded() );
+   EXPECT_LE( 10, batches.load() );
+   EXPECT_FALSE( reduction.m_timedOut );
+   EXPECT_EQ( 100ll * 101 / 2, e.Flush() );
+}
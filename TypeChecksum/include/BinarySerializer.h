@@ -0,0 +1,346 @@
+#pragma once
+
+#include "Reflectable.h"
+
+#include <boost/utility/string_ref.hpp>
+
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <limits>
+#include <cassert>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+/** Binary format of REFLECTABLE types, the checksum of the type comes first:
+ *
+ *  - Trivially copyable members are copied as they are in little endian
+ *  - Strings and vectors are prefixed by their number of elements as uint32,
+ *    serializing longer ones throws std::length_error
+ *  - Reflectable members are encoded member by member, without a checksum
+ *
+ *  Members are not aligned, so BinaryView reads them by memcpy.
+ * */
+
+namespace detail
+{
+   static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "The binary format is little endian, byte swapping is not supported yet");
+
+   typedef std::uint32_t lengthType;
+
+   inline void require(char const* p, char const* end, size_t size)
+   {
+      if (static_cast<size_t>(end - p) < size)
+      {  throw std::out_of_range("Binary buffer too short"); }
+   }
+
+   inline void append(std::vector<char>& out, void const* data, size_t size)
+   {
+      auto const bytes(static_cast<char const*>(data));
+      out.insert(out.end(), bytes, bytes + size);
+   }
+
+   inline void take(char const*& p, char const* end, void* data, size_t size)
+   {
+      require(p, end, size);
+      std::memcpy(data, p, size);
+      p += size;
+   }
+
+   inline void appendLength(std::vector<char>& out, size_t size)
+   {
+      if (size > std::numeric_limits<lengthType>::max())
+      {  throw std::length_error("String or vector too long for the binary format"); }
+      auto const length(static_cast<lengthType>(size));
+      append(out, &length, sizeof(length));
+   }
+
+   inline lengthType takeLength(char const*& p, char const* end)
+   {
+      lengthType length(0);
+      take(p, end, &length, sizeof(length));
+      return length;
+   }
+
+   template<class T>
+   struct isTrivialMember : std::integral_constant<bool, std::is_trivially_copyable<T>::value && !std::is_pointer<T>::value && !supportsMemberInfo<T>::value> {};
+
+   /** Read only access to an encoded vector of trivially copyable elements */
+   template<class T>
+   struct ArrayView
+   {
+      ArrayView(char const* data, size_t size) : m_data(data), m_size(size) {}
+
+      size_t size() const
+      {  return m_size; }
+
+      T operator[](size_t index) const
+      {
+         assert(index < m_size);
+         T r;
+         std::memcpy(&r, m_data + index * sizeof(T), sizeof(T));
+         return r;
+      }
+
+   private:
+      char const* m_data;
+      size_t m_size;
+   };
+
+   template<class T, class Enable = void>
+   struct codec
+   {
+      static_assert(sizeof(T) == 0, "Member type is not supported by the binary format");
+   };
+}
+
+/** Accesses the members of an encoded T in place, without deserializing it */
+template<class T>
+struct BinaryView
+{
+   struct bodyOnly {};
+
+   /** Checks the checksum at the beginning of data */
+   BinaryView(char const* data, size_t size) : m_begin(data), m_end(data + size)
+   {
+      std::uint64_t checksum(0);
+      detail::take(m_begin, m_end, &checksum, sizeof(checksum));
+      if (checksum != typeChecksum<T>())
+      {  throw std::invalid_argument("Binary buffer contains a different type"); }
+   }
+
+   BinaryView(char const* begin, char const* end, bodyOnly) : m_begin(begin), m_end(end) {}
+
+   /** A copy for trivially copyable members, a boost::string_ref for strings, an
+    *  ArrayView for vectors of trivially copyable types and a BinaryView otherwise
+    * */
+   template<int N>
+   auto get() const
+   {
+      auto p(m_begin);
+      detail::codec<T>::template skip<0, N>(p, m_end);
+      return detail::codec<typename detail::reflector::memberType<N, T>::type>::view(p, m_end);
+   }
+
+private:
+   char const* m_begin;
+   char const* m_end;
+};
+
+namespace detail
+{
+   template<class T>
+   struct codec<T, typename std::enable_if<isTrivialMember<T>::value>::type>
+   {
+      static void write(std::vector<char>& out, T const& v)
+      {  append(out, &v, sizeof(T)); }
+
+      static void read(char const*& p, char const* end, T& v)
+      {  take(p, end, &v, sizeof(T)); }
+
+      static void skip(char const*& p, char const* end)
+      {
+         require(p, end, sizeof(T));
+         p += sizeof(T);
+      }
+
+      static T view(char const* p, char const* end)
+      {
+         T r;
+         read(p, end, r);
+         return r;
+      }
+   };
+
+   template<>
+   struct codec<std::string>
+   {
+      static void write(std::vector<char>& out, std::string const& v)
+      {
+         appendLength(out, v.size());
+         append(out, v.data(), v.size());
+      }
+
+      static void read(char const*& p, char const* end, std::string& v)
+      {
+         auto const length(takeLength(p, end));
+         require(p, end, length);
+         v.assign(p, length);
+         p += length;
+      }
+
+      static void skip(char const*& p, char const* end)
+      {
+         auto const length(takeLength(p, end));
+         require(p, end, length);
+         p += length;
+      }
+
+      static boost::string_ref view(char const* p, char const* end)
+      {
+         auto const length(takeLength(p, end));
+         require(p, end, length);
+         return boost::string_ref(p, length);
+      }
+   };
+
+   template<class T, class A>
+   struct codec<std::vector<T, A>>
+   {
+      static void write(std::vector<char>& out, std::vector<T, A> const& v)
+      {
+         appendLength(out, v.size());
+         write(out, v, isTrivialMember<T>());
+      }
+
+      static void read(char const*& p, char const* end, std::vector<T, A>& v)
+      {
+         auto const length(takeLength(p, end));
+         read(p, end, v, length, isTrivialMember<T>());
+      }
+
+      static void skip(char const*& p, char const* end)
+      {
+         auto const length(takeLength(p, end));
+         skip(p, end, length, isTrivialMember<T>());
+      }
+
+      static ArrayView<T> view(char const* p, char const* end)
+      {
+         static_assert(isTrivialMember<T>::value, "Only vectors of trivially copyable types can be viewed");
+         auto const length(takeLength(p, end));
+         require(p, end, length * sizeof(T));
+         return ArrayView<T>(p, length);
+      }
+
+   private:
+      static void write(std::vector<char>& out, std::vector<T, A> const& v, std::true_type)
+      {  append(out, v.data(), v.size() * sizeof(T)); }
+
+      static void write(std::vector<char>& out, std::vector<T, A> const& v, std::false_type)
+      {
+         for (auto const& item : v)
+         {  codec<T>::write(out, item); }
+      }
+
+      static void read(char const*& p, char const* end, std::vector<T, A>& v, lengthType length, std::true_type)
+      {
+         require(p, end, length * sizeof(T)); ///< Before a corrupt length causes a huge allocation
+         v.resize(length);
+         take(p, end, v.data(), length * sizeof(T));
+      }
+
+      static void read(char const*& p, char const* end, std::vector<T, A>& v, lengthType length, std::false_type)
+      {
+         v.clear();
+         v.reserve(std::min<size_t>(length, end - p));
+         for (lengthType i(0); i < length; ++i)
+         {
+            v.emplace_back();
+            codec<T>::read(p, end, v.back());
+         }
+      }
+
+      static void skip(char const*& p, char const* end, lengthType length, std::true_type)
+      {
+         require(p, end, length * sizeof(T));
+         p += length * sizeof(T);
+      }
+
+      static void skip(char const*& p, char const* end, lengthType length, std::false_type)
+      {
+         for (lengthType i(0); i < length; ++i)
+         {  codec<T>::skip(p, end); }
+      }
+   };
+
+   template<class T>
+   struct codec<T, typename std::enable_if<supportsMemberInfo<T>::value>::type>
+   {
+      template<int I, int N = reflector::members<T>::count>
+      using more = std::integral_constant<bool, (I < N)>;
+
+      static void write(std::vector<char>& out, T const& v)
+      {  write<0>(out, v, more<0>()); }
+
+      static void read(char const*& p, char const* end, T& v)
+      {  read<0>(p, end, v, more<0>()); }
+
+      static void skip(char const*& p, char const* end)
+      {  skip<0, reflector::members<T>::count>(p, end); }
+
+      /** Skips the members from I to N */
+      template<int I, int N>
+      static void skip(char const*& p, char const* end)
+      {  skip<I, N>(p, end, more<I, N>()); }
+
+      static BinaryView<T> view(char const* p, char const* end)
+      {  return BinaryView<T>(p, end, typename BinaryView<T>::bodyOnly()); }
+
+   private:
+      template<int I>
+      static void write(std::vector<char>& out, T const& v, std::true_type)
+      {
+         codec<typename reflector::memberType<I, T>::type>::write(out, reflector::getMemberInfo<I>(v).get());
+         write<I + 1>(out, v, more<I + 1>());
+      }
+
+      template<int I>
+      static void write(std::vector<char>&, T const&, std::false_type)
+      {}
+
+      template<int I>
+      static void read(char const*& p, char const* end, T& v, std::true_type)
+      {
+         codec<typename reflector::memberType<I, T>::type>::read(p, end, reflector::getMemberInfo<I>(v).get());
+         read<I + 1>(p, end, v, more<I + 1>());
+      }
+
+      template<int I>
+      static void read(char const*&, char const*, T&, std::false_type)
+      {}
+
+      template<int I, int N>
+      static void skip(char const*& p, char const* end, std::true_type)
+      {
+         codec<typename reflector::memberType<I, T>::type>::skip(p, end);
+         skip<I + 1, N>(p, end, more<I + 1, N>());
+      }
+
+      template<int I, int N>
+      static void skip(char const*&, char const*, std::false_type)
+      {}
+   };
+} ///< detail
+
+template<class ClassType>
+std::vector<char> serialize(ClassType const& value)
+{
+   std::vector<char> r;
+   auto const checksum(typeChecksum<ClassType>());
+   detail::append(r, &checksum, sizeof(checksum));
+   detail::codec<ClassType>::write(r, value);
+   return r;
+}
+
+/** Throws std::invalid_argument when the checksum does not match and std::out_of_range when data is too short */
+template<class ClassType>
+void deserialize(char const* data, size_t size, ClassType& value)
+{
+   auto const end(data + size);
+   std::uint64_t checksum(0);
+   detail::take(data, end, &checksum, sizeof(checksum));
+   if (checksum != typeChecksum<ClassType>())
+   {  throw std::invalid_argument("Binary buffer contains a different type"); }
+   detail::codec<ClassType>::read(data, end, value);
+}
+
+template<class ClassType>
+ClassType deserialize(char const* data, size_t size)
+{
+   ClassType r;
+   deserialize(data, size, r);
+   return r;
+}
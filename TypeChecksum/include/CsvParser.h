@@ -0,0 +1,289 @@
+#pragma once
+
+#include "Reflectable.h"
+#include "SoaVector.h"
+
+#include <string>
+#include <vector>
+#include <future>
+#include <thread>
+#include <limits>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace
+{
+   /** Read only mapping of a whole file */
+   struct MappedInput
+   {
+      explicit MappedInput(std::string const& path) : m_data(nullptr), m_size(0)
+      {
+         auto const fd(open(path.c_str(), O_RDONLY));
+         if (fd == -1)
+         {  throw std::system_error(errno, std::generic_category(), "Unable to open " + path); }
+
+         struct stat s;
+         if (fstat(fd, &s) == -1)
+         {
+            auto const error(errno);
+            close(fd);
+            throw std::system_error(error, std::generic_category(), "Unable to stat " + path);
+         }
+
+         m_size = s.st_size;
+         if (m_size > 0)
+         {
+            auto const memory(mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0));
+            auto const error(errno);
+            if (memory == MAP_FAILED)
+            {
+               close(fd);
+               throw std::system_error(error, std::generic_category(), "Unable to map " + path);
+            }
+            m_data = static_cast<char const*>(memory);
+            madvise(const_cast<char*>(m_data), m_size, MADV_SEQUENTIAL);
+         }
+         close(fd);
+      }
+
+      ~MappedInput()
+      {
+         if (m_data != nullptr)
+         {  munmap(const_cast<char*>(m_data), m_size); }
+      }
+
+      MappedInput(MappedInput const&) = delete;
+      MappedInput& operator=(MappedInput const&) = delete;
+
+      char const* m_data;
+      size_t m_size;
+   };
+}
+
+namespace detail
+{
+   inline void malformed(char const* begin, char const* end)
+   {  throw std::invalid_argument("Malformed csv field '" + std::string(begin, end) + "'"); }
+
+   /** Parses the digits in [p, end) into value, returns false on overflow */
+   inline bool parseDigits(char const*& p, char const* end, std::uint64_t& value)
+   {
+      for (; p != end && *p >= '0' && *p <= '9'; ++p)
+      {
+         auto const digit(static_cast<std::uint64_t>(*p - '0'));
+         if (value > (std::numeric_limits<std::uint64_t>::max() - digit) / 10)
+         {  return false; }
+         value = value * 10 + digit;
+      }
+      return true;
+   }
+
+   template<class T>
+   typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type parseField(char const* begin, char const* end, T& value)
+   {
+      auto p(begin);
+      auto const negative(p != end && *p == '-');
+      if (negative || (p != end && *p == '+')) { ++p; }
+
+      std::uint64_t magnitude(0);
+      auto const digits(p);
+      if (!parseDigits(p, end, magnitude) || p != end || p == digits
+       || magnitude > static_cast<std::uint64_t>(std::numeric_limits<T>::max()) + (negative ? 1 : 0))
+      {  malformed(begin, end); }
+      value = negative ? static_cast<T>(0 - magnitude) : static_cast<T>(magnitude);
+   }
+
+   template<class T>
+   typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type parseField(char const* begin, char const* end, T& value)
+   {
+      auto p(begin);
+      std::uint64_t magnitude(0);
+      if (!parseDigits(p, end, magnitude) || p != end || p == begin || magnitude > std::numeric_limits<T>::max())
+      {  malformed(begin, end); }
+      value = static_cast<T>(magnitude);
+   }
+
+   inline float toFloating(char const* s, char** last, float)
+   {  return std::strtof(s, last); }
+
+   inline double toFloating(char const* s, char** last, double)
+   {  return std::strtod(s, last); }
+
+   inline long double toFloating(char const* s, char** last, long double)
+   {  return std::strtold(s, last); }
+
+   /** Exact for doubles when the digits fit into 53 bits and the exponent is within 22,
+    *  since mantissa and power of ten are both exact doubles then and there is a single
+    *  rounding only. Everything else is passed to strtod, strtof or strtold, a float
+    *  rounded from the double would be rounded twice.
+    * */
+   template<class T>
+   typename std::enable_if<std::is_floating_point<T>::value>::type parseField(char const* begin, char const* end, T& value)
+   {
+      static double const powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11
+                                     , 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+      auto p(begin);
+      auto const negative(p != end && *p == '-');
+      if (negative || (p != end && *p == '+')) { ++p; }
+
+      std::uint64_t mantissa(0);
+      auto const integral(p);
+      auto fast(parseDigits(p, end, mantissa));
+      auto digits(p - integral);
+      int exponent(0);
+      if (fast && p != end && *p == '.')
+      {
+         auto const fraction(++p);
+         fast = parseDigits(p, end, mantissa);
+         exponent = -static_cast<int>(p - fraction);
+         digits += p - fraction;
+      }
+      if (fast && p != end && (*p == 'e' || *p == 'E'))
+      {
+         ++p;
+         auto const negativeExponent(p != end && *p == '-');
+         if (negativeExponent || (p != end && *p == '+')) { ++p; }
+         auto const exponentDigits(p);
+         std::uint64_t e(0);
+         fast = parseDigits(p, end, e) && e <= 1000; ///< Out of range for any T, left to strtod without overflowing exponent
+         if (fast && (p != end || p == exponentDigits)) { malformed(begin, end); }
+         if (fast) { exponent += negativeExponent ? -static_cast<int>(e) : static_cast<int>(e); }
+      }
+
+      if (digits == 0) { malformed(begin, end); }
+      if (std::is_same<T, double>::value && fast && p == end && mantissa < (1ull << 53) && exponent >= -22 && exponent <= 22)
+      {
+         auto const magnitude(exponent < 0 ? mantissa / powers[-exponent] : mantissa * powers[exponent]);
+         value = static_cast<T>(negative ? -magnitude : magnitude);
+         return;
+      }
+
+      std::string const copy(begin, end); ///< strtod requires a terminated string
+      char* last(nullptr);
+      value = toFloating(copy.c_str(), &last, T());
+      if (last != copy.c_str() + copy.size())
+      {  malformed(begin, end); }
+   }
+
+   inline void parseField(char const* begin, char const* end, std::string& value)
+   {  value.assign(begin, end); }
+
+   /** Assigns the fields of a line to the members in order of declaration */
+   template<class T, int I = 0, bool = (I < reflector::members<T>::count)>
+   struct csvRow
+   {
+      static void parse(char const* p, char const* end, char delimiter, T& row)
+      {
+         auto const last(I + 1 == reflector::members<T>::count);
+         auto const found(static_cast<char const*>(std::memchr(p, delimiter, end - p)));
+         if (last == (found != nullptr))
+         {  throw std::invalid_argument("Csv line has a wrong number of fields '" + std::string(p, end) + "'"); }
+
+         auto const fieldEnd(last ? end : found);
+         parseField(p, fieldEnd, reflector::getMemberInfo<I>(row).get());
+         csvRow<T, I + 1>::parse(fieldEnd + 1, end, delimiter, row);
+      }
+   };
+
+   template<class T, int I>
+   struct csvRow<T, I, false>
+   {
+      static void parse(char const*, char const*, char, T&)
+      {}
+   };
+
+   /** Parses all lines starting in [begin, end) */
+   template<class ContainerT>
+   ContainerT parseLines(char const* begin, char const* end, char delimiter)
+   {
+      typedef typename ContainerT::value_type value_type;
+      ContainerT r;
+      value_type row;
+      for (auto p(begin); p < end; )
+      {
+         auto lineEnd(static_cast<char const*>(std::memchr(p, '\n', end - p)));
+         auto const next(lineEnd == nullptr ? end : lineEnd + 1);
+         if (lineEnd == nullptr) { lineEnd = end; }
+         if (lineEnd != p && lineEnd[-1] == '\r') { --lineEnd; }
+         if (lineEnd != p) ///< Empty lines are skipped
+         {
+            csvRow<value_type>::parse(p, lineEnd, delimiter, row);
+            r.push_back(row);
+         }
+         p = next;
+      }
+      return r;
+   }
+
+   template<class T>
+   void appendChunk(std::vector<T>& r, std::vector<T>&& chunk)
+   {
+      if (r.empty()) { r = std::move(chunk); }
+      else           { r.insert(r.end(), std::make_move_iterator(chunk.begin()), std::make_move_iterator(chunk.end())); }
+   }
+
+   template<class T>
+   void appendChunk(SoaVector<T>& r, SoaVector<T>&& chunk)
+   {  r.append(std::move(chunk)); }
+
+   template<class ContainerT>
+   ContainerT parseCsv(std::string const& path, char delimiter, bool header, size_t chunkCount)
+   {
+      MappedInput const input(path);
+      auto begin(input.m_data);
+      auto const end(input.m_data + input.m_size);
+      if (header && begin != end)
+      {
+         auto const lineEnd(static_cast<char const*>(std::memchr(begin, '\n', end - begin)));
+         begin = lineEnd == nullptr ? end : lineEnd + 1;
+      }
+
+      /** Chunks are split at line ends, so each one can be parsed on its own */
+      chunkCount = std::max<size_t>(1, std::min<size_t>(chunkCount, (end - begin) / 4096 + 1));
+      std::vector<std::future<ContainerT>> chunks;
+      auto chunkBegin(begin);
+      for (size_t c(1); c <= chunkCount && chunkBegin < end; ++c)
+      {
+         auto chunkEnd(c == chunkCount ? end : std::max(chunkBegin, begin + (end - begin) * c / chunkCount));
+         if (chunkEnd != end)
+         {
+            auto const lineEnd(static_cast<char const*>(std::memchr(chunkEnd, '\n', end - chunkEnd)));
+            chunkEnd = lineEnd == nullptr ? end : lineEnd + 1;
+         }
+         chunks.emplace_back(std::async(std::launch::async, [chunkBegin, chunkEnd, delimiter]
+         {  return parseLines<ContainerT>(chunkBegin, chunkEnd, delimiter); }));
+         chunkBegin = chunkEnd;
+      }
+
+      ContainerT r;
+      for (auto& chunk : chunks)
+      {  appendChunk(r, chunk.get()); }
+      return r;
+   }
+}
+
+/** Reads a text file with a line per T and the fields in order of the members.
+ *  Integers, floating point numbers and strings are supported, quoting is not.
+ *  The file is memory mapped and split into chunkCount parts parsed in parallel.
+ *  Throws std::invalid_argument for malformed lines.
+ * */
+template<class T>
+std::vector<T> parseCsv(std::string const& path, char delimiter = ',', bool header = true, size_t chunkCount = std::thread::hardware_concurrency())
+{  return detail::parseCsv<std::vector<T>>(path, delimiter, header, chunkCount); }
+
+/** Same as parseCsv but into columns */
+template<class T>
+SoaVector<T> parseCsvColumns(std::string const& path, char delimiter = ',', bool header = true, size_t chunkCount = std::thread::hardware_concurrency())
+{  return detail::parseCsv<SoaVector<T>>(path, delimiter, header, chunkCount); }
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <boost/type_traits.hpp>
+#include <boost/mpl/range_c.hpp>
+#include <boost/mpl/for_each.hpp>
+#include <boost/preprocessor.hpp>
+#include <boost/ref.hpp>
+#include <boost/bind.hpp>
+
+#include <string>
+#include <vector>
+#include <tuple>
+#include <cstdint>
+#include <type_traits>
+
+#define REM(...) __VA_ARGS__
+#define EAT(...)
+#define STRIP(x) EAT x        // Strip off the type
+#define PAIR(x) REM x         // Show the type without parenthesis
+#define TYPEOF(x) DETAIL_TYPEOF(DETAIL_TYPEOF_PROBE x,) // Show the type without the name
+#define DETAIL_TYPEOF(...) DETAIL_TYPEOF_HEAD(__VA_ARGS__)
+#define DETAIL_TYPEOF_HEAD(x, ...) REM x
+#define DETAIL_TYPEOF_PROBE(...) (__VA_ARGS__),
+
+namespace detail
+{
+   // A helper metafunction for adding const to a type
+   template<class M, class T>
+   struct make_const { typedef T type; };
+
+   template<class M, class T>
+   struct make_const<const M, T> { typedef typename boost::add_const<T>::type type; };
+
+   std::uint64_t const fnvOffset = 14695981039346656037ull;
+   std::uint64_t const fnvPrime = 1099511628211ull;
+
+   /** FNV-1a including the terminating zero, so consecutive strings cannot be shifted into each other */
+   constexpr std::uint64_t fnv1a(char const* s, std::uint64_t seed = fnvOffset)
+   {
+      do
+      {
+         seed ^= static_cast<unsigned char>(*s);
+         seed *= fnvPrime;
+      } while (*s++ != 0);
+      return seed;
+   }
+}
+
+/** Type and name of the members are taken as written in the declaration, the
+ *  checksum is therefore the same for all compilers but changes when a type is
+ *  spelled differently, like 'unsigned' instead of 'unsigned int'.
+ * */
+#define REFLECTABLE(...) \
+static const int memberCount = BOOST_PP_VARIADIC_SIZE(__VA_ARGS__); \
+public: bool hasMemberInfo() const { return true; } private: \
+friend struct detail::reflector; \
+template<int N, class ClassType> struct MemberInfo {}; \
+BOOST_PP_SEQ_FOR_EACH_I(REFLECT_EACH, data, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+#define REFLECT_EACH(r, data, index, member) \
+PAIR(member); \
+template<class ClassType> \
+struct MemberInfo<index, ClassType> \
+{ \
+   typedef decltype(member) member_type; \
+   ClassType& m_class; \
+   MemberInfo(ClassType& _class) : m_class(_class) {} \
+   typename detail::make_const<ClassType, decltype(member)>::type& get() \
+   {  return m_class.STRIP(member); } \
+   typename boost::add_const<decltype(member)>::type& get() const \
+   {  return m_class.STRIP(member); } \
+   static constexpr char const* typeName() \
+   {  return BOOST_PP_STRINGIZE(TYPEOF(member)); } \
+   static constexpr char const* memberName() \
+   {  return BOOST_PP_STRINGIZE(STRIP(member)); } \
+   std::string type() const \
+   {  return typeName(); } \
+   std::string name() const \
+   {  return memberName(); } \
+}; \
+
+namespace detail
+{
+   template<class T> class supportsMemberInfo
+   {
+       typedef char (&Yes)[1];
+       typedef char (&No)[2];
+
+       template<class U>
+       static Yes check(U const* i, typename std::enable_if<std::is_same<bool, decltype(i->hasMemberInfo())>::value>::type* = 0);
+       template<class U>
+       static No check(...);
+   public:
+       static const bool value = sizeof(Yes) == sizeof(supportsMemberInfo::check<T>((typename std::remove_reference<T>::type*)0));
+   };
+
+   struct reflector
+   {
+      template<int N, class ClassType> ///< Get memberInfo at index N, get() of it returns a const reference for a const ClassType only
+      static typename ClassType::template MemberInfo<N, ClassType> getMemberInfo(ClassType& _class)
+      {  return typename ClassType::template MemberInfo<N, ClassType>(_class); }
+
+      template<int N, class ClassType> ///< Get the type of the member at index N
+      struct memberType
+      {  typedef typename ClassType::template MemberInfo<N, ClassType>::member_type type; };
+
+      template<int N, class ClassType> ///< Get the name of the member at index N
+      static constexpr char const* memberName()
+      {  return ClassType::template MemberInfo<N, ClassType>::memberName(); }
+
+      template<class ClassType>        ///< Get the number of fields
+      struct members
+      {  static const int count = ClassType::memberCount; };
+
+      /** Types on the path from the outermost type to the current one */
+      template<class... T>
+      struct visited {};
+
+      template<class T, class Visited>
+      struct isVisited : std::false_type {};
+
+      template<class T, class Head, class... Tail>
+      struct isVisited<T, visited<Head, Tail...>> : std::conditional<std::is_same<T, Head>::value, std::true_type, isVisited<T, visited<Tail...>>>::type {};
+
+      /** Folds type and name of the members from N on into seed, the layout of
+       *  reflectable members is folded in between. Members pointing to a type
+       *  on the current path contribute their type name only, that breaks the
+       *  cycle of self referencing types like list nodes.
+       * */
+      template<class ClassType, class Visited = visited<>, int N = 0, bool = (N < members<ClassType>::count)>
+      struct checksum
+      {
+         static constexpr std::uint64_t value(std::uint64_t seed)
+         {
+            typedef typename ClassType::template MemberInfo<N, ClassType> info;
+            return checksum<ClassType, Visited, N + 1>::value(fnv1a(info::memberName(), nested<typename info::member_type, ClassType, Visited>::value(fnv1a(info::typeName(), seed))));
+         }
+      };
+
+      template<class ClassType, class Visited, int N>
+      struct checksum<ClassType, Visited, N, false>
+      {
+         static constexpr std::uint64_t value(std::uint64_t seed)
+         {  return seed; }
+      };
+
+      template<class MemberType, class ClassType, class Visited>
+      struct nested;
+
+      template<class MemberType, class ClassType, class... Visited>
+      struct nested<MemberType, ClassType, visited<Visited...>>
+      {
+         typedef typename std::remove_cv<typename std::remove_pointer<MemberType>::type>::type type;
+         typedef visited<ClassType, Visited...> path;
+
+         static constexpr std::uint64_t value(std::uint64_t seed)
+         {  return fold(seed, std::integral_constant<bool, supportsMemberInfo<type>::value && !isVisited<type, path>::value>()); }
+
+         static constexpr std::uint64_t fold(std::uint64_t seed, std::true_type)
+         {  return checksum<type, path>::value(seed); }
+
+         static constexpr std::uint64_t fold(std::uint64_t seed, std::false_type)
+         {  return seed; }
+      };
+   };
+
+   struct memberVisitor
+   {
+      template<class ClassType, class Visitor, class MemberType>
+      void operator()(ClassType const& c, Visitor visitor, MemberType const&);
+   };
+
+   template<class ClassType, class Visitor>
+   void visitMember(ClassType const& c, Visitor visitor)
+   {
+      typedef boost::mpl::range_c<int, 0, reflector::members<ClassType>::count> range;
+      boost::mpl::for_each<range>(boost::bind<void>(memberVisitor(), boost::ref(c), visitor, _1));
+   }
+
+   template<class MemberType, class Visitor>
+   void visitNested(MemberType const& m, Visitor visitor, std::true_type)
+   {  visitMember(m, visitor); }
+
+   template<class MemberType, class Visitor>
+   void visitNested(MemberType const&, Visitor, std::false_type)
+   {}
+
+   /** Visits the members of reflectable members right after the member itself */
+   template<class ClassType, class Visitor, class MemberType>
+   void memberVisitor::operator()(ClassType const& c, Visitor visitor, MemberType const&)
+   {
+      auto const info(reflector::getMemberInfo<MemberType::value>(c));
+      visitor(info);
+      visitNested(info.get(), visitor, std::integral_constant<bool, supportsMemberInfo<typename decltype(info)::member_type>::value>());
+   }
+} ///< detail
+
+template<class ClassType>
+std::vector<std::tuple<std::string, std::string>> getMemberList(ClassType const& c)
+{
+   std::vector<std::tuple<std::string, std::string>> memberList;
+   detail::visitMember(c, [&](auto const& memberInfo){ memberList.emplace_back(std::make_tuple(memberInfo.type(), memberInfo.name())); });
+   return memberList;
+}
+
+/** Structural checksum over type and name of all members, evaluated at compile time */
+template<class ClassType>
+constexpr std::uint64_t typeChecksum()
+{  return detail::reflector::checksum<ClassType>::value(detail::fnvOffset); }
+
+template<class ClassType>
+constexpr std::uint64_t getTypeHash(ClassType const&)
+{  return typeChecksum<ClassType>(); }
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "BinarySerializer.h"
+
+#include <vector>
+#include <limits>
+#include <utility>
+#include <cstdint>
+#include <stdexcept>
+#include <functional>
+#include <type_traits>
+#include <unordered_map>
+
+namespace detail
+{
+   constexpr bool equalNames(char const* a, char const* b)
+   {
+      while (*a != 0 && *a == *b) { ++a; ++b; }
+      return *a == *b;
+   }
+
+   /** Index of the member of ClassType called name or -1 */
+   template<class ClassType, int I = 0, bool = (I < reflector::members<ClassType>::count)>
+   struct memberIndex
+   {
+      static constexpr int of(char const* name)
+      {  return equalNames(reflector::memberName<I, ClassType>(), name) ? I : memberIndex<ClassType, I + 1>::of(name); }
+   };
+
+   template<class ClassType, int I>
+   struct memberIndex<ClassType, I, false>
+   {
+      static constexpr int of(char const*)
+      {  return -1; }
+   };
+
+   template<class From, class To>
+   void convertMembers(From const& from, To& to);
+
+   template<class From, class To>
+   struct convertsMembers : std::integral_constant<bool, supportsMemberInfo<From>::value && supportsMemberInfo<To>::value && !std::is_same<From, To>::value> {};
+
+   template<class From, class To>
+   void convertValue(From const& from, To& to, typename std::enable_if<convertsMembers<From, To>::value>::type* = 0)
+   {  convertMembers(from, to); }
+
+   /** Arithmetic types convert when every value of From is a value of To, so long long
+    *  to int or double to float do not. Other types are checked by assignability only.
+    * */
+   template<class From, class To, bool = std::is_arithmetic<From>::value && std::is_arithmetic<To>::value>
+   struct isLossless : std::true_type {};
+
+   template<class From, class To>
+   struct isLossless<From, To, true> : std::integral_constant<bool,
+         std::numeric_limits<To>::digits >= std::numeric_limits<From>::digits
+      && (std::is_signed<To>::value || !std::is_signed<From>::value)
+      && (std::is_floating_point<To>::value || !std::is_floating_point<From>::value)
+      && std::numeric_limits<To>::max_exponent >= std::numeric_limits<From>::max_exponent> {};
+
+   template<class From, class To>
+   void convertValue(From const& from, To& to, typename std::enable_if<!convertsMembers<From, To>::value>::type* = 0)
+   {
+      static_assert(std::is_assignable<To&, From const&>::value, "Member changed its type to an incompatible one, rename it instead");
+      static_assert(isLossless<From, To>::value, "Member changed its type to a narrower one, rename it instead");
+      to = from;
+   }
+
+   template<class From, class To, class FromA, class ToA>
+   typename std::enable_if<!std::is_same<From, To>::value>::type convertValue(std::vector<From, FromA> const& from, std::vector<To, ToA>& to)
+   {
+      to.clear(); ///< Existing elements would keep the values of their new members
+      to.resize(from.size());
+      for (size_t i(0); i < from.size(); ++i)
+      {  convertValue(from[i], to[i]); }
+   }
+
+   template<int J, class From, class To>
+   void convertMember(From const&, To&, std::integral_constant<int, -1>)
+   {} ///< New member, keeps the value it got by construction, the target is reset before
+
+   template<int J, class From, class To, int I>
+   void convertMember(From const& from, To& to, std::integral_constant<int, I>)
+   {  convertValue(reflector::getMemberInfo<I>(from).get(), reflector::getMemberInfo<J>(to).get()); }
+
+   /** The mapping by name is resolved at compile time, what remains is an assignment per member */
+   template<class From, class To, int... J>
+   void convertMembers(From const& from, To& to, std::integer_sequence<int, J...>)
+   {
+      int const expand[] = {0, (convertMember<J>(from, to, std::integral_constant<int, memberIndex<From>::of(reflector::memberName<J, To>())>()), 0)...};
+      (void)expand;
+   }
+
+   template<class From, class To>
+   void convertMembers(From const& from, To& to)
+   {  convertMembers(from, to, std::make_integer_sequence<int, reflector::members<To>::count>()); }
+}
+
+/** Decodes the binary format of older versions of T. Every older version is
+ *  registered by its own REFLECTABLE type. Members are mapped by name, nested
+ *  reflectable members recursively. Members missing in the old version get
+ *  their default, also when the value is reused, members removed since then
+ *  are dropped. Members changed to
+ *  an incompatible or a narrower type fail to compile.
+ * */
+template<class T>
+struct SchemaRegistry
+{
+   typedef std::function<void(char const*, size_t, T&)> decoder_type;
+
+   SchemaRegistry() : m_decoders() {}
+
+   template<class OldT>
+   void add()
+   {
+      m_decoders[typeChecksum<OldT>()] = [](char const* data, size_t size, T& value)
+      {
+         OldT old;
+         deserialize(data, size, old);
+         value = T(); ///< A reused value would keep the values of the previous message in new members
+         detail::convertMembers(old, value);
+      };
+   }
+
+   bool supports(std::uint64_t checksum) const
+   {  return checksum == typeChecksum<T>() || m_decoders.count(checksum) != 0; }
+
+   /** Throws std::invalid_argument for unknown versions */
+   void decode(char const* data, size_t size, T& value) const
+   {
+      std::uint64_t checksum(0);
+      auto p(data);
+      detail::take(p, data + size, &checksum, sizeof(checksum));
+      if (checksum == typeChecksum<T>())
+      {
+         deserialize(data, size, value);
+         return;
+      }
+
+      auto const decoder(m_decoders.find(checksum));
+      if (decoder == m_decoders.end())
+      {  throw std::invalid_argument("Binary buffer contains an unknown version"); }
+      decoder->second(data, size, value);
+   }
+
+   T decode(char const* data, size_t size) const
+   {
+      T r;
+      decode(data, size, r);
+      return r;
+   }
+
+private:
+   std::unordered_map<std::uint64_t, decoder_type> m_decoders;
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "Reflectable.h"
+
+#include <vector>
+#include <algorithm>
+#include <tuple>
+#include <utility>
+#include <iterator>
+#include <type_traits>
+
+namespace detail
+{
+   template<class ClassType, class Sequence = std::make_integer_sequence<int, reflector::members<ClassType>::count>>
+   struct columns;
+
+   /** A vector per member of ClassType */
+   template<class ClassType, int... I>
+   struct columns<ClassType, std::integer_sequence<int, I...>>
+   {
+      typedef std::tuple<std::vector<typename reflector::memberType<I, ClassType>::type>...> type;
+
+      template<class FunctionT>
+      static void forEach(FunctionT&& function)
+      {
+         int const expand[] = {0, (function(std::integral_constant<int, I>()), 0)...};
+         (void)expand;
+      }
+   };
+}
+
+/** Container of reflectable types storing each member in a vector of its own.
+ *  Loops over a single column touch the bytes of this member only and can be
+ *  vectorized by the compiler. Rows are assembled on access, see Row.
+ * */
+template<class T>
+struct SoaVector
+{
+   static_assert(detail::supportsMemberInfo<T>::value, "SoaVector requires a REFLECTABLE type");
+
+   typedef detail::columns<T> columns_type;
+   typedef T value_type;
+
+   /** Proxy referring to the members of a row in place */
+   template<class ContainerT>
+   struct RowT
+   {
+      RowT(ContainerT& container, size_t index) : m_container(container), m_index(index) {}
+
+      template<int N>
+      auto& get() const
+      {  return m_container.template column<N>()[m_index]; }
+
+      operator T() const
+      {  return m_container.at(m_index); }
+
+      RowT& operator=(T const& value)
+      {
+         m_container.set(m_index, value);
+         return *this;
+      }
+
+   private:
+      ContainerT& m_container;
+      size_t m_index;
+   };
+
+   typedef RowT<SoaVector> Row;
+   typedef RowT<SoaVector const> ConstRow;
+
+   SoaVector() : m_columns() {}
+
+   size_t size() const
+   {  return std::get<0>(m_columns).size(); }
+
+   bool empty() const
+   {  return size() == 0; }
+
+   /** On an exception all columns keep their rows, only their capacities may differ */
+   void reserve(size_t count)
+   {  columns_type::forEach([&](auto n){ std::get<decltype(n)::value>(m_columns).reserve(count); }); }
+
+   void clear()
+   {  columns_type::forEach([&](auto n){ std::get<decltype(n)::value>(m_columns).clear(); }); }
+
+   /** Strong guarantee, when copying a member throws the columns grown already are shrunk again */
+   void push_back(T const& value)
+   {
+      auto const count(size());
+      grow(count + 1);
+      try
+      {  columns_type::forEach([&](auto n){ std::get<decltype(n)::value>(m_columns).push_back(detail::reflector::getMemberInfo<decltype(n)::value>(value).get()); }); }
+      catch (...)
+      {
+         truncate(count);
+         throw;
+      }
+   }
+
+   /** Moves all rows of other to the end, column by column. When moving a
+    *  member throws, this keeps its rows but values of other may be moved already.
+    * */
+   void append(SoaVector&& other)
+   {
+      auto const count(size());
+      grow(count + other.size());
+      try
+      {
+         columns_type::forEach([&](auto n)
+         {
+            auto& to(std::get<decltype(n)::value>(m_columns));
+            auto& from(std::get<decltype(n)::value>(other.m_columns));
+            to.insert(to.end(), std::make_move_iterator(from.begin()), std::make_move_iterator(from.end()));
+         });
+      }
+      catch (...)
+      {
+         truncate(count);
+         throw;
+      }
+      other.clear();
+   }
+
+   /** Assembles a copy of the row, T has to be default constructible */
+   T at(size_t index) const
+   {
+      T r;
+      columns_type::forEach([&](auto n){ detail::reflector::getMemberInfo<decltype(n)::value>(r).get() = std::get<decltype(n)::value>(m_columns)[index]; });
+      return r;
+   }
+
+   void set(size_t index, T const& value)
+   {  columns_type::forEach([&](auto n){ std::get<decltype(n)::value>(m_columns)[index] = detail::reflector::getMemberInfo<decltype(n)::value>(value).get(); }); }
+
+   Row operator[](size_t index)
+   {  return Row(*this, index); }
+
+   ConstRow operator[](size_t index) const
+   {  return ConstRow(*this, index); }
+
+   /** All values of the member at index N */
+   template<int N>
+   auto& column()
+   {  return std::get<N>(m_columns); }
+
+   template<int N>
+   auto const& column() const
+   {  return std::get<N>(m_columns); }
+
+private:
+   /** Reserves geometrically, so inserting up to count rows does not reallocate any column */
+   void grow(size_t count)
+   {
+      columns_type::forEach([&](auto n)
+      {
+         auto& column(std::get<decltype(n)::value>(m_columns));
+         if (column.capacity() < count)
+         {  column.reserve(std::max(count, 2 * column.capacity())); }
+      });
+   }
+
+   void truncate(size_t count)
+   {
+      columns_type::forEach([&](auto n)
+      {
+         auto& column(std::get<decltype(n)::value>(m_columns));
+         column.erase(column.begin() + std::min(count, column.size()), column.end());
+      });
+   }
+
+   typename columns_type::type m_columns;
+};
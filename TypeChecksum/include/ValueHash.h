@@ -0,0 +1,129 @@
+#pragma once
+
+#include "Reflectable.h"
+
+#include <boost/functional/hash.hpp>
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+
+namespace detail
+{
+   /** Consumes 8 bytes per step, the final mix is the one of MurmurHash3 */
+   struct valueHasher
+   {
+      valueHasher() : m_state(fnvOffset) {}
+
+      /** The size is mixed in as well, so adjacent members cannot be shifted into each other */
+      void bytes(void const* data, size_t size)
+      {
+         auto p(static_cast<unsigned char const*>(data));
+         auto rest(size);
+         for (; rest >= sizeof(std::uint64_t); p += sizeof(std::uint64_t), rest -= sizeof(std::uint64_t))
+         {
+            std::uint64_t word;
+            std::memcpy(&word, p, sizeof(word));
+            mix(word);
+         }
+         std::uint64_t tail(0);
+         if (rest != 0) ///< p may be null for empty containers
+         {  std::memcpy(&tail, p, rest); }
+         mix(tail);
+         mix(size);
+      }
+
+      /** Members of reflectable members are visited on their own */
+      template<class T>
+      void add(T const&, typename std::enable_if<supportsMemberInfo<T>::value>::type* = 0)
+      {}
+
+      template<class T>
+      void add(T const& v, typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type* = 0)
+      {  bytes(&v, sizeof(v)); }
+
+      template<class T>
+      void add(T const& v, typename std::enable_if<std::is_floating_point<T>::value>::type* = 0)
+      {
+         T const normalized(v == 0 ? T(0) : v); ///< -0. equals 0.
+         bytes(&normalized, sizeof(normalized));
+      }
+
+      void add(char const* v)
+      {  bytes(v, std::strlen(v)); }
+
+      void add(std::string const& v)
+      {  bytes(v.data(), v.size()); }
+
+      /** Vectors of integers are hashed as a single block, except the packed std::vector<bool> */
+      template<class T, class A>
+      void add(std::vector<T, A> const& v)
+      {  add(v, std::integral_constant<bool, (std::is_integral<T>::value && !std::is_same<T, bool>::value) || std::is_enum<T>::value>()); }
+
+      template<class T, class A>
+      void add(std::vector<T, A> const& v, std::true_type)
+      {  bytes(v.data(), v.size() * sizeof(T)); }
+
+      template<class T, class A>
+      void add(std::vector<T, A> const& v, std::false_type)
+      {
+         for (auto const& item : v)
+         {  hashValue(item); }
+         mix(v.size());
+      }
+
+      /** Everything else by boost::hash, a hash_value() next to the type is sufficient */
+      template<class T>
+      void add(T const& v, typename std::enable_if<!supportsMemberInfo<T>::value && !std::is_arithmetic<T>::value && !std::is_enum<T>::value && !std::is_pointer<T>::value>::type* = 0)
+      {  mix(boost::hash<T>()(v)); }
+
+      template<class T>
+      void hashValue(T const& v, typename std::enable_if<supportsMemberInfo<T>::value>::type* = 0)
+      {  visitMember(v, [this](auto const& memberInfo){ add(memberInfo.get()); }); }
+
+      template<class T>
+      void hashValue(T const& v, typename std::enable_if<!supportsMemberInfo<T>::value>::type* = 0)
+      {  add(v); }
+
+      void mix(std::uint64_t word)
+      {
+         m_state ^= word;
+         m_state *= fnvPrime;
+         m_state ^= m_state >> 29;
+      }
+
+      std::uint64_t result() const
+      {
+         auto h(m_state);
+         h ^= h >> 33;
+         h *= 0xff51afd7ed558ccdull;
+         h ^= h >> 33;
+         h *= 0xc4ceb9fe1a85ec53ull;
+         h ^= h >> 33;
+         return h;
+      }
+
+      std::uint64_t m_state;
+   };
+}
+
+/** Hash over the content of all members, nested reflectable members included.
+ *  Objects comparing equal member by member get the same hash value.
+ * */
+template<class ClassType>
+std::uint64_t getValueHash(ClassType const& c)
+{
+   detail::valueHasher hasher;
+   hasher.hashValue(c);
+   return hasher.result();
+}
+
+/** Hash for unordered containers of reflectable types */
+struct ValueHash
+{
+   template<class ClassType>
+   size_t operator()(ClassType const& c) const
+   {  return static_cast<size_t>(getValueHash(c)); }
+};
@@ -0,0 +1,101 @@
+
+#include "../include/BinarySerializer.h"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+   struct Location
+   {
+      Location() : m_latitude(0.), m_longitude(0.) {}
+      Location(double latitude, double longitude) : m_latitude(latitude), m_longitude(longitude) {}
+
+      friend bool operator==(Location const& a, Location const& b)
+      {  return a.m_latitude == b.m_latitude && a.m_longitude == b.m_longitude; }
+
+   private:
+      REFLECTABLE
+      (
+         (double) m_latitude,
+         (double) m_longitude
+      )
+   };
+
+   struct Station
+   {
+      Station() : m_id(0), m_name(), m_location(), m_readings(), m_tags() {}
+      Station(int id, std::string name, Location location, std::vector<float> readings, std::vector<std::string> tags) :
+          m_id(id)
+         ,m_name(std::move(name))
+         ,m_location(location)
+         ,m_readings(std::move(readings))
+         ,m_tags(std::move(tags))
+      {}
+
+      friend bool operator==(Station const& a, Station const& b)
+      {  return a.m_id == b.m_id && a.m_name == b.m_name && a.m_location == b.m_location && a.m_readings == b.m_readings && a.m_tags == b.m_tags; }
+
+   private:
+      REFLECTABLE
+      (
+         (int) m_id,
+         (std::string) m_name,
+         (Location) m_location,
+         (std::vector<float>) m_readings,
+         (std::vector<std::string>) m_tags
+      )
+   };
+
+   Station const zugspitze(23, "Zugspitze", Location(47.42, 10.98), {-3.5f, -4.f, -2.25f}, {"alpine", "weather"});
+}
+
+TEST(BinarySerializer, Layout)
+{
+   auto const buffer(serialize(Location(1., 2.)));
+   ASSERT_EQ(sizeof(std::uint64_t) + 2 * sizeof(double), buffer.size());
+
+   std::uint64_t checksum(0);
+   double longitude(0.);
+   std::memcpy(&checksum, buffer.data(), sizeof(checksum));
+   std::memcpy(&longitude, buffer.data() + sizeof(checksum) + sizeof(double), sizeof(longitude));
+   EXPECT_EQ(typeChecksum<Location>(), checksum);
+   EXPECT_EQ(2., longitude);
+}
+
+TEST(BinarySerializer, RoundTrip)
+{
+   auto const buffer(serialize(zugspitze));
+   EXPECT_EQ(zugspitze, deserialize<Station>(buffer.data(), buffer.size()));
+}
+
+TEST(BinarySerializer, Errors)
+{
+   auto const buffer(serialize(zugspitze));
+   EXPECT_THROW(deserialize<Station>(buffer.data(), buffer.size() - 1), std::out_of_range);
+   EXPECT_THROW(deserialize<Location>(buffer.data(), buffer.size()), std::invalid_argument);
+   EXPECT_THROW(BinaryView<Location>(buffer.data(), buffer.size()), std::invalid_argument);
+
+   std::vector<char> out;
+   EXPECT_THROW(detail::appendLength(out, std::numeric_limits<detail::lengthType>::max() + size_t(1)), std::length_error);
+   EXPECT_TRUE(out.empty());
+}
+
+TEST(BinarySerializer, View)
+{
+   auto const buffer(serialize(zugspitze));
+   BinaryView<Station> view(buffer.data(), buffer.size());
+   EXPECT_EQ(23, view.get<0>());
+   EXPECT_EQ("Zugspitze", view.get<1>());
+   EXPECT_EQ(buffer.data() + sizeof(std::uint64_t) + sizeof(int) + sizeof(std::uint32_t), view.get<1>().data()); ///< Refers to the buffer
+   EXPECT_EQ(10.98, view.get<2>().get<1>());
+
+   auto const readings(view.get<3>());
+   ASSERT_EQ(3u, readings.size());
+   EXPECT_EQ(-2.25f, readings[2]);
+}
@@ -0,0 +1,132 @@
+
+#include "../include/CsvParser.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+#include <cstdlib>
+#include <cmath>
+
+#include <unistd.h>
+
+namespace
+{
+   struct Measurement
+   {
+      Measurement() : m_sensor(), m_count(0), m_value(0.) {}
+
+      std::string const& sensor() const { return m_sensor; }
+      int count() const { return m_count; }
+      double value() const { return m_value; }
+
+   private:
+      REFLECTABLE
+      (
+         (std::string) m_sensor,
+         (int) m_count,
+         (double) m_value
+      )
+   };
+
+   /** File removed again at the end of the test */
+   struct TemporaryFile
+   {
+      explicit TemporaryFile(std::string const& content) : m_path()
+      {
+         char path[] = "/tmp/CsvParserTest-XXXXXX";
+         auto const fd(mkstemp(path));
+         close(fd);
+         m_path = path;
+         std::ofstream(m_path) << content;
+      }
+
+      ~TemporaryFile()
+      {  unlink(m_path.c_str()); }
+
+      std::string m_path;
+   };
+
+   template<class T>
+   T parse(std::string const& field)
+   {
+      T r;
+      detail::parseField(field.data(), field.data() + field.size(), r);
+      return r;
+   }
+}
+
+TEST(CsvParser, Numbers)
+{
+   EXPECT_EQ(-42, parse<int>("-42"));
+   EXPECT_EQ(2147483647, parse<int>("2147483647"));
+   EXPECT_EQ(-2147483647 - 1, parse<int>("-2147483648"));
+   EXPECT_THROW(parse<int>("2147483648"), std::invalid_argument);
+   EXPECT_THROW(parse<unsigned>("-1"), std::invalid_argument);
+   EXPECT_THROW(parse<int>("12a"), std::invalid_argument);
+   EXPECT_THROW(parse<int>(""), std::invalid_argument);
+
+   EXPECT_EQ(0.1, parse<double>("0.1"));
+   EXPECT_EQ(-2.5, parse<double>("-2.5"));
+   EXPECT_EQ(.5, parse<double>(".5"));
+   EXPECT_EQ(1.5e10, parse<double>("1.5e10"));
+   EXPECT_EQ(1.5e-300, parse<double>("1.5e-300"));                       ///< By strtod
+   EXPECT_EQ(0.12345678901234567890, parse<double>("0.12345678901234567890"));
+   EXPECT_THROW(parse<double>("1.5x"), std::invalid_argument);
+   EXPECT_THROW(parse<double>("-"), std::invalid_argument);
+   EXPECT_THROW(parse<double>("1e"), std::invalid_argument);
+   EXPECT_THROW(parse<double>("1e+"), std::invalid_argument);
+   EXPECT_EQ(0., parse<double>("1.5e-2147483648"));                      ///< Exponent out of int range
+   EXPECT_EQ(0., parse<double>("1.5e-99999999999999999999"));
+   EXPECT_EQ(HUGE_VAL, parse<double>("1.5e2147483648"));
+
+   EXPECT_EQ(std::strtof("1.000000536441803", nullptr), parse<float>("1.000000536441803")); ///< Rounded twice via double
+   EXPECT_EQ(0.1f, parse<float>("0.1"));
+}
+
+TEST(CsvParser, Rows)
+{
+   TemporaryFile const file("sensor,count,value\nnorth,3,1.25\r\n\nsouth,-7,2e3\n");
+   auto const rows(parseCsv<Measurement>(file.m_path));
+   ASSERT_EQ(2u, rows.size());
+   EXPECT_EQ("north", rows[0].sensor());
+   EXPECT_EQ(1.25, rows[0].value());
+   EXPECT_EQ(-7, rows[1].count());
+   EXPECT_EQ(2000., rows[1].value());
+}
+
+TEST(CsvParser, Tsv)
+{
+   TemporaryFile const file("north\t3\t1.25");
+   auto const rows(parseCsv<Measurement>(file.m_path, '\t', false));
+   ASSERT_EQ(1u, rows.size());
+   EXPECT_EQ(3, rows[0].count());
+}
+
+TEST(CsvParser, WrongFieldCount)
+{
+   TemporaryFile const few("north,3\n");
+   EXPECT_THROW(parseCsv<Measurement>(few.m_path, ',', false), std::invalid_argument);
+   TemporaryFile const many("north,3,1,2\n");
+   EXPECT_THROW(parseCsv<Measurement>(many.m_path, ',', false), std::invalid_argument);
+}
+
+TEST(CsvParser, ParallelChunks)
+{
+   std::string content("sensor,count,value\n");
+   for (int i(0); i < 10000; ++i)
+   {  content += "s" + std::to_string(i) + "," + std::to_string(i) + "," + std::to_string(i) + ".5\n"; }
+   TemporaryFile const file(content);
+
+   auto const rows(parseCsv<Measurement>(file.m_path, ',', true, 4));
+   ASSERT_EQ(10000u, rows.size());
+   for (int i(0); i < 10000; ++i)
+   {  EXPECT_EQ(i, rows[i].count()); }
+
+   auto const columns(parseCsvColumns<Measurement>(file.m_path, ',', true, 4));
+   ASSERT_EQ(10000u, columns.size());
+   EXPECT_EQ(9999.5, columns.column<2>().back());
+   EXPECT_EQ("s1234", columns.column<0>()[1234]);
+}
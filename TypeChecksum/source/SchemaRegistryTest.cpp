@@ -0,0 +1,159 @@
+
+#include "../include/SchemaRegistry.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+namespace v1
+{
+   struct Contact
+   {
+      Contact() : m_mail() {}
+      Contact(std::string mail) : m_mail(std::move(mail)) {}
+
+   private:
+      REFLECTABLE
+      (
+         (std::string) m_mail
+      )
+   };
+
+   struct Customer
+   {
+      Customer() : m_id(0), m_name(), m_contacts(), m_discount(0) {}
+      Customer(int id, std::string name, std::vector<Contact> contacts, int discount) :
+          m_id(id)
+         ,m_name(std::move(name))
+         ,m_contacts(std::move(contacts))
+         ,m_discount(discount)
+      {}
+
+   private:
+      REFLECTABLE
+      (
+         (int) m_id,
+         (std::string) m_name,
+         (std::vector<Contact>) m_contacts,
+         (int) m_discount
+      )
+   };
+}
+
+namespace v2
+{
+   struct Contact
+   {
+      Contact() : m_mail(), m_phone("unknown") {}
+      Contact(std::string mail, std::string phone) : m_mail(std::move(mail)), m_phone(std::move(phone)) {}
+
+      std::string const& mail() const { return m_mail; }
+      std::string const& phone() const { return m_phone; }
+
+   private:
+      REFLECTABLE
+      (
+         (std::string) m_mail,
+         (std::string) m_phone
+      )
+   };
+
+   /** Members reordered, m_id widened, m_discount removed and m_level added */
+   struct Customer
+   {
+      Customer() : m_name(), m_level(1), m_id(0), m_contacts() {}
+      Customer(std::string name, int level, long long id, std::vector<Contact> contacts) :
+          m_name(std::move(name))
+         ,m_level(level)
+         ,m_id(id)
+         ,m_contacts(std::move(contacts))
+      {}
+
+      std::string const& name() const { return m_name; }
+      int level() const { return m_level; }
+      long long id() const { return m_id; }
+      std::vector<Contact> const& contacts() const { return m_contacts; }
+
+   private:
+      REFLECTABLE
+      (
+         (std::string) m_name,
+         (int) m_level,
+         (long long) m_id,
+         (std::vector<Contact>) m_contacts
+      )
+   };
+}
+
+TEST(SchemaRegistry, CurrentVersion)
+{
+   SchemaRegistry<v2::Customer> registry;
+   auto const buffer(serialize(v2::Customer()));
+   EXPECT_TRUE(registry.supports(typeChecksum<v2::Customer>()));
+   EXPECT_EQ(1, registry.decode(buffer.data(), buffer.size()).level());
+}
+
+TEST(SchemaRegistry, OlderVersion)
+{
+   SchemaRegistry<v2::Customer> registry;
+   auto const buffer(serialize(v1::Customer(23, "Tom", {v1::Contact("tom@space"), v1::Contact("tom@home")}, 5)));
+   EXPECT_FALSE(registry.supports(typeChecksum<v1::Customer>()));
+   EXPECT_THROW(registry.decode(buffer.data(), buffer.size()), std::invalid_argument);
+
+   registry.add<v1::Customer>();
+   EXPECT_TRUE(registry.supports(typeChecksum<v1::Customer>()));
+   auto const customer(registry.decode(buffer.data(), buffer.size()));
+   EXPECT_EQ(23, customer.id());
+   EXPECT_EQ("Tom", customer.name());
+   EXPECT_EQ(1, customer.level());
+   ASSERT_EQ(2u, customer.contacts().size());
+   EXPECT_EQ("tom@home", customer.contacts()[1].mail());
+   EXPECT_EQ("unknown", customer.contacts()[1].phone());
+}
+
+TEST(SchemaRegistry, ReusedValue)
+{
+   SchemaRegistry<v2::Customer> registry;
+   registry.add<v1::Customer>();
+   auto const current(serialize(v2::Customer("Ann", 3, 42, {v2::Contact("ann@space", "555"), v2::Contact("ann@home", "777")})));
+   auto const first(serialize(v1::Customer(23, "Tom", {v1::Contact("tom@space")}, 5)));
+   auto const second(serialize(v1::Customer(24, "Tim", {}, 0)));
+
+   v2::Customer customer;
+   registry.decode(current.data(), current.size(), customer);
+   EXPECT_EQ(3, customer.level());
+
+   registry.decode(first.data(), first.size(), customer);
+   EXPECT_EQ(23, customer.id());
+   EXPECT_EQ(1, customer.level());
+   ASSERT_EQ(1u, customer.contacts().size());
+   EXPECT_EQ("tom@space", customer.contacts()[0].mail());
+   EXPECT_EQ("unknown", customer.contacts()[0].phone());
+
+   registry.decode(second.data(), second.size(), customer);
+   EXPECT_EQ(24, customer.id());
+   EXPECT_EQ("Tim", customer.name());
+   EXPECT_TRUE(customer.contacts().empty());
+}
+
+TEST(SchemaRegistry, MemberIndex)
+{
+   static_assert(detail::memberIndex<v1::Customer>::of("m_contacts") == 2, "Resolved at compile time");
+   static_assert(detail::memberIndex<v1::Customer>::of("m_level") == -1, "Resolved at compile time");
+}
+
+TEST(SchemaRegistry, Narrowing)
+{
+   static_assert(detail::isLossless<int, long long>::value, "Widened");
+   static_assert(detail::isLossless<int, double>::value, "Exact in double");
+   static_assert(detail::isLossless<float, double>::value, "Widened");
+   static_assert(detail::isLossless<unsigned short, int>::value, "Widened");
+   static_assert(detail::isLossless<std::string, std::string>::value, "Not arithmetic");
+   static_assert(!detail::isLossless<long long, int>::value, "Truncates");
+   static_assert(!detail::isLossless<long long, double>::value, "Rounds");
+   static_assert(!detail::isLossless<double, float>::value, "Rounds");
+   static_assert(!detail::isLossless<double, long long>::value, "Truncates");
+   static_assert(!detail::isLossless<int, unsigned>::value, "Drops the sign");
+}
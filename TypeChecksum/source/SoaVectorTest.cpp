@@ -0,0 +1,128 @@
+
+#include "../include/SoaVector.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <numeric>
+#include <stdexcept>
+
+namespace
+{
+   struct Record
+   {
+      Record() : m_name(), m_age(0), m_score(0.) {}
+      Record(std::string name, int age, double score) : m_name(std::move(name)), m_age(age), m_score(score) {}
+
+      friend bool operator==(Record const& a, Record const& b)
+      {  return a.m_name == b.m_name && a.m_age == b.m_age && a.m_score == b.m_score; }
+
+   private:
+      REFLECTABLE
+      (
+         (std::string) m_name,
+         (int) m_age,
+         (double) m_score
+      )
+   };
+
+   /** Throws on copy and move while armed */
+   struct Fragile
+   {
+      Fragile() : m_value(0) {}
+      Fragile(int value) : m_value(value) {}
+      Fragile(Fragile const& other) : m_value(other.m_value) { check(); }
+      Fragile(Fragile&& other) : m_value(other.m_value) { check(); }
+      Fragile& operator=(Fragile const&) = default;
+
+      static void check()
+      {
+         if (armed)
+         {  throw std::runtime_error("Fragile"); }
+      }
+
+      static bool armed;
+      int m_value;
+   };
+
+   bool Fragile::armed = false;
+
+   struct FragileRecord
+   {
+      FragileRecord() : m_name(), m_fragile() {}
+      FragileRecord(std::string name, int value) : m_name(std::move(name)), m_fragile(value) {}
+
+   private:
+      REFLECTABLE
+      (
+         (std::string) m_name,
+         (Fragile) m_fragile
+      )
+   };
+}
+
+TEST(SoaVector, PushBackAndAt)
+{
+   SoaVector<Record> records;
+   EXPECT_TRUE(records.empty());
+   records.reserve(2);
+   records.push_back(Record("Tom", 42, 1.5));
+   records.push_back(Record("Ann", 23, 2.5));
+   ASSERT_EQ(2u, records.size());
+   EXPECT_EQ(Record("Ann", 23, 2.5), records.at(1));
+   EXPECT_EQ(Record("Tom", 42, 1.5), static_cast<Record>(records[0]));
+
+   records.clear();
+   EXPECT_TRUE(records.empty());
+}
+
+TEST(SoaVector, Column)
+{
+   SoaVector<Record> records;
+   for (int i(0); i < 100; ++i)
+   {  records.push_back(Record("", i, i * .5)); }
+
+   auto const& ages(records.column<1>());
+   EXPECT_EQ(4950, std::accumulate(ages.begin(), ages.end(), 0));
+   EXPECT_EQ(&records.column<1>()[1], &records.column<1>()[0] + 1); ///< Contiguous
+}
+
+TEST(SoaVector, Row)
+{
+   SoaVector<Record> records;
+   records.push_back(Record("Tom", 42, 1.5));
+
+   auto row(records[0]);
+   row.get<1>() = 43;
+   EXPECT_EQ(43, records.column<1>()[0]);
+   EXPECT_EQ("Tom", row.get<0>());
+
+   row = Record("Ann", 23, 2.5);
+   EXPECT_EQ(Record("Ann", 23, 2.5), records.at(0));
+
+   SoaVector<Record> const& constRecords(records);
+   EXPECT_EQ(23, constRecords[0].get<1>());
+}
+
+TEST(SoaVector, ExceptionSafety)
+{
+   SoaVector<FragileRecord> records;
+   records.push_back(FragileRecord("Tom", 42));
+
+   Fragile::armed = true;
+   EXPECT_THROW(records.push_back(FragileRecord("Ann", 23)), std::runtime_error);
+   EXPECT_EQ(1u, records.column<0>().size());
+   EXPECT_EQ(1u, records.column<1>().size());
+
+   Fragile::armed = false;
+   SoaVector<FragileRecord> other;
+   other.push_back(FragileRecord("Ann", 23));
+   other.push_back(FragileRecord("Bob", 5));
+   Fragile::armed = true;
+   EXPECT_THROW(records.append(std::move(other)), std::runtime_error);
+   Fragile::armed = false;
+   EXPECT_EQ(1u, records.column<0>().size());
+   EXPECT_EQ(1u, records.column<1>().size());
+   EXPECT_EQ("Tom", records.column<0>()[0]);
+   EXPECT_EQ(42, records.column<1>()[0].m_value);
+}
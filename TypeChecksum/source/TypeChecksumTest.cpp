@@ -1,135 +1,13 @@
 
 //#include "../include/TypeChecksum.h"
 
-#include <boost/type_traits.hpp>
-#include <boost/mpl/range_c.hpp>
-#include <boost/mpl/for_each.hpp>
-#include <boost/preprocessor.hpp>
-#include <boost/ref.hpp>
-#include <boost/bind.hpp>
-#include <boost/functional/hash.hpp>
+#include "../include/Reflectable.h"
 
 #include <gtest/gtest.h>
 
-#include <typeinfo>
+#include <sstream>
 #include <iostream>
 
-#include <cxxabi.h>
-
-#define REM(...) __VA_ARGS__
-#define EAT(...)
-#define STRIP(x) EAT x        // Strip off the type
-#define PAIR(x) REM x         // Show the type without parenthesis
-
-namespace detail
-{
-   // A helper metafunction for adding const to a type
-   template<class M, class T>
-   struct make_const { typedef T type; };
-
-   template<class M, class T>
-   struct make_const<const M, T> { typedef typename boost::add_const<T>::type type; };
-}
-
-#define REFLECTABLE(...) \
-static const int memberCount = BOOST_PP_VARIADIC_SIZE(__VA_ARGS__); \
-public: bool hasMemberInfo() const { return true; } private: \
-friend struct detail::reflector; \
-template<int N, class ClassType> struct MemberInfo {}; \
-BOOST_PP_SEQ_FOR_EACH_I(REFLECT_EACH, data, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
-
-#define REFLECT_EACH(r, data, index, member) \
-PAIR(member); \
-template<class ClassType> \
-struct MemberInfo<index, ClassType> \
-{ \
-   ClassType const& m_class; \
-   MemberInfo(ClassType const& _class) : m_class(_class) {} \
-   typename detail::make_const<ClassType, decltype(member)>::type& get() \
-   {  return m_class.STRIP(member); } \
-   typename boost::add_const<decltype(member)>::type& get() const \
-   {  return m_class.STRIP(member); } \
-   std::string type() const \
-   { \
-      int status(0); \
-      auto name(typeid(member).name()); \
-      auto result(abi::__cxa_demangle(name, 0, 0, &status)); \
-      return status == 0 ? result : name; \
-   } \
-   std::string name() const \
-   {  return BOOST_PP_STRINGIZE(STRIP(member)); } \
-}; \
-
-namespace detail 
-{
-   template<class T> class supportsMemberInfo
-   {
-       typedef char (&Yes)[1];
-       typedef char (&No)[2];
-
-       template<class U> 
-       static Yes check(U const* i, typename std::enable_if<std::is_same<bool, decltype(i->hasMemberInfo())>::value>::type* = 0);
-       template<class U> 
-       static No check(...);
-   public:
-       static const bool value = sizeof(Yes) == sizeof(supportsMemberInfo::check<T>((typename std::remove_reference<T>::type*)0));
-   };
-
-   struct reflector
-   {
-      template<int N, class ClassType> ///< Get memberInfo at index N
-      static typename ClassType::template MemberInfo<N, ClassType> getMemberInfo(ClassType const& _class)
-      {  return typename ClassType::template MemberInfo<N, ClassType>(_class); }
-         
-      template<class ClassType>        ///< Get the number of fields
-      struct members
-      {  static const int count = ClassType::memberCount; };
-   };
-
-   struct memberVisitor
-   {
-      template<class ClassType, class Visitor, class MemberType>
-      void operator()(ClassType const& c, Visitor visitor, MemberType const&);
-   };
-   
-   template<class ClassType, class Visitor>
-   void visitMember(ClassType const& c, Visitor visitor)
-   {
-      typedef boost::mpl::range_c<int, 0, reflector::members<ClassType>::count> range;
-      boost::mpl::for_each<range>(boost::bind<void>(memberVisitor(), boost::ref(c), visitor, _1));
-   }
-   
-   template<class ClassType, class Visitor, class MemberType>
-   void memberVisitor::operator()(ClassType const& c, Visitor visitor, MemberType const& m)
-   {
-      visitor(reflector::getMemberInfo<MemberType::value>(c));
-      
-      /** \todo Add recursion into member when 
-                detail::supportsMemberInfo<MemberType::value>::value is true
-                
-          if supportsMemberInfo -> visitMember(m, visitor);
-      */   
-   }
-} ///< detail
-
-template<class ClassType>
-std::vector<std::tuple<std::string, std::string>> getMemberList(ClassType const& c)
-{  
-   std::vector<std::tuple<std::string, std::string>> memberList;
-   detail::visitMember(c, [&](auto const& memberInfo){ memberList.emplace_back(std::make_tuple(memberInfo.type(), memberInfo.name())); }); 
-   return memberList;
-}
-
-template<class ClassType>
-size_t getTypeHash(ClassType const& c)
-{
-   auto const memberList(getMemberList(c));
-   size_t seed(0);
-   for (auto const& item : memberList) ///< Currently we use the types only to calculate the hash value
-   {  boost::hash_combine(seed, std::get<0>(item)); }
-   return seed;
-}
-
 ///< User code
 
 struct Address
@@ -221,3 +99,111 @@ TEST(TypeCheck, Simple)
       {  std::cout << std::get<0>(member) << ": " << std::get<1>(member) << '\n'; }
    }   
 }
+
+struct Point
+{
+private:
+   REFLECTABLE
+   (
+      (int) m_x,
+      (int) m_y
+   )
+};
+
+struct Renamed
+{
+private:
+   REFLECTABLE
+   (
+      (int) m_x,
+      (int) m_z
+   )
+};
+
+TEST(TypeCheck, CompileTime)
+{
+   static_assert(typeChecksum<Point>() != typeChecksum<Renamed>(), "Member names are part of the checksum");
+   static_assert(typeChecksum<Address>() != typeChecksum<Person>(), "Member types are part of the checksum");
+
+   Person majorTom("Major Tom", 42, Address("Spaceroad", 23), Dimensions(179));
+   Person eT("E.T.", 300, Address("Spaceroad", 5), Dimensions(142));
+   EXPECT_EQ(getTypeHash(majorTom), getTypeHash(eT));
+}
+
+TEST(TypeCheck, Stable)
+{
+   using detail::fnv1a;
+   EXPECT_EQ(fnv1a("m_no", fnv1a("unsigned int", fnv1a("m_road", fnv1a("std::string")))), typeChecksum<Address>());
+   EXPECT_EQ(0xaf63bd4c8601b7dfull, fnv1a("")); ///< The offset basis followed by the terminating zero
+}
+
+namespace v1
+{
+   struct Inner { private: REFLECTABLE((int) m_value) };
+   struct Outer { private: REFLECTABLE((Inner) m_inner) };
+}
+
+namespace v2
+{
+   struct Inner { private: REFLECTABLE((long) m_value) };
+   struct Outer { private: REFLECTABLE((Inner) m_inner) };
+}
+
+struct Node
+{
+private:
+   REFLECTABLE
+   (
+      (int) m_value,
+      (Node*) m_next
+   )
+};
+
+struct Child;
+
+struct Parent
+{
+private:
+   REFLECTABLE
+   (
+      (Child*) m_child
+   )
+};
+
+struct Child
+{
+private:
+   REFLECTABLE
+   (
+      (Parent*) m_parent,
+      (int) m_age
+   )
+};
+
+TEST(TypeCheck, Nested)
+{
+   static_assert(typeChecksum<v1::Outer>() != typeChecksum<v2::Outer>(), "Layout of nested members is part of the checksum");
+
+   using detail::fnv1a;
+   auto const address(typeChecksum<Address>());
+   auto seed(fnv1a("Address", fnv1a("m_age", fnv1a("int", fnv1a("m_name", fnv1a("const char *"))))));
+   seed = fnv1a("m_dimensions", fnv1a("Dimensions", fnv1a("m_address", detail::reflector::checksum<Address>::value(seed))));
+   EXPECT_EQ(seed, typeChecksum<Person>());
+   EXPECT_NE(address, typeChecksum<Person>());
+
+   Person majorTom("Major Tom", 42, Address("Spaceroad", 23), Dimensions(179));
+   auto const memberList(getMemberList(majorTom));
+   ASSERT_EQ(6u, memberList.size());
+   EXPECT_EQ("m_address", std::get<1>(memberList[2]));
+   EXPECT_EQ("m_road", std::get<1>(memberList[3]));
+   EXPECT_EQ("m_no", std::get<1>(memberList[4]));
+   EXPECT_EQ("m_dimensions", std::get<1>(memberList[5]));
+}
+
+TEST(TypeCheck, Cycle)
+{
+   using detail::fnv1a;
+   static_assert(typeChecksum<Node>() == fnv1a("m_next", fnv1a("Node*", fnv1a("m_value", fnv1a("int")))), "Self reference contributes its type name only");
+   static_assert(typeChecksum<Parent>() != typeChecksum<Child>(), "Both ends of a cycle are folded in");
+   EXPECT_EQ(typeChecksum<Parent>(), fnv1a("m_child", fnv1a("m_age", fnv1a("int", fnv1a("m_parent", fnv1a("Parent*", fnv1a("Child*")))))));
+}
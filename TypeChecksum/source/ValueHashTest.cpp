@@ -0,0 +1,106 @@
+
+#include "../include/ValueHash.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+namespace
+{
+   /** Not reflectable, hashed by boost::hash */
+   struct Colour
+   {
+      int m_rgb;
+
+      friend bool operator==(Colour const& a, Colour const& b)
+      {  return a.m_rgb == b.m_rgb; }
+
+      friend size_t hash_value(Colour const& c)
+      {  return boost::hash<int>()(c.m_rgb); }
+   };
+
+   struct Size
+   {
+      Size(double width, double height) : m_width(width), m_height(height) {}
+
+      friend bool operator==(Size const& a, Size const& b)
+      {  return a.m_width == b.m_width && a.m_height == b.m_height; }
+
+   private:
+      REFLECTABLE
+      (
+         (double) m_width,
+         (double) m_height
+      )
+   };
+
+   struct Article
+   {
+      Article(std::string name, Size size, std::vector<int> stock, Colour colour) :
+          m_name(std::move(name))
+         ,m_size(size)
+         ,m_stock(std::move(stock))
+         ,m_colour(colour)
+      {}
+
+      friend bool operator==(Article const& a, Article const& b)
+      {  return a.m_name == b.m_name && a.m_size == b.m_size && a.m_stock == b.m_stock && a.m_colour == b.m_colour; }
+
+   private:
+      REFLECTABLE
+      (
+         (std::string) m_name,
+         (Size) m_size,
+         (std::vector<int>) m_stock,
+         (Colour) m_colour
+      )
+   };
+
+   struct Flags
+   {
+      explicit Flags(std::vector<bool> flags) : m_flags(std::move(flags)) {}
+
+   private:
+      REFLECTABLE
+      (
+         (std::vector<bool>) m_flags
+      )
+   };
+}
+
+TEST(ValueHash, EqualValues)
+{
+   Article const a("shirt", Size(.5, .75), {1, 2, 3}, Colour{0xff0000});
+   Article const b("shirt", Size(.5, .75), {1, 2, 3}, Colour{0xff0000});
+   EXPECT_EQ(getValueHash(a), getValueHash(b));
+   EXPECT_EQ(getValueHash(Size(0., 1.)), getValueHash(Size(-0., 1.)));
+}
+
+TEST(ValueHash, DifferentValues)
+{
+   Article const a("shirt", Size(.5, .75), {1, 2, 3}, Colour{0xff0000});
+   EXPECT_NE(getValueHash(a), getValueHash(Article("Shirt", Size(.5, .75), {1, 2, 3}, Colour{0xff0000})));
+   EXPECT_NE(getValueHash(a), getValueHash(Article("shirt", Size(.5, .7), {1, 2, 3}, Colour{0xff0000})));
+   EXPECT_NE(getValueHash(a), getValueHash(Article("shirt", Size(.5, .75), {1, 2}, Colour{0xff0000})));
+   EXPECT_NE(getValueHash(a), getValueHash(Article("shirt", Size(.5, .75), {1, 2, 3}, Colour{0x00ff00})));
+   EXPECT_NE(getValueHash(Size(1., 2.)), getValueHash(Size(2., 1.)));
+   EXPECT_NE(getValueHash(Article("abcdefgh", Size(0., 0.), {}, Colour{0})), getValueHash(Article("", Size(0., 0.), {}, Colour{0})));
+}
+
+TEST(ValueHash, UnorderedSet)
+{
+   std::unordered_set<Article, ValueHash> articles;
+   articles.emplace("shirt", Size(.5, .75), std::vector<int>{1}, Colour{1});
+   articles.emplace("shirt", Size(.5, .75), std::vector<int>{1}, Colour{1});
+   articles.emplace("shoe", Size(.25, .1), std::vector<int>{}, Colour{2});
+   EXPECT_EQ(2u, articles.size());
+}
+
+TEST(ValueHash, VectorOfBool)
+{
+   EXPECT_EQ(getValueHash(Flags({true, false})), getValueHash(Flags({true, false})));
+   EXPECT_NE(getValueHash(Flags({true, false})), getValueHash(Flags({false, true})));
+   EXPECT_NE(getValueHash(Flags({})), getValueHash(Flags({false})));
+}
@@ -0,0 +1,11 @@
+#!/bin/bash
+# Runs the processor benchmarks with hardware cache counters,
+#   ./perf.ProcessorBenchmark.sh [bin postfix] [benchmark filter]
+# e.g. ./perf.ProcessorBenchmark.sh Release 'FalseSharing|Chain'
+DIR="$( cd "$(dirname "$0")" ; pwd -P )"
+BENCHMARK=$DIR/bin/$1/ProcessorBenchmark
+FILTER=${2:-.}
+
+perf stat \
+   -e cycles,instructions,cache-references,cache-misses,L1-dcache-load-misses,LLC-load-misses \
+   $BENCHMARK --benchmark_filter="$FILTER"